@@ -16,9 +16,9 @@ INCLUDE_DIR=""          # Which directories do we want to include.
 LIBRARIES=""            # What libraries do we want to include
 
 if platform.system()=="Linux":
-    ARGUMENTS="-D LINUX" # -D is a #define sent to preprocessor
+    ARGUMENTS="-D LINUX -pthread" # -D is a #define sent to preprocessor
     INCLUDE_DIR="-I ./include/ -I ./../common/thirdparty/glm/"
-    LIBRARIES="-lSDL2 -ldl"
+    LIBRARIES="-lSDL2 -ldl -lEGL"
 elif platform.system()=="Darwin":
     ARGUMENTS="-D MAC" # -D is a #define sent to the preprocessor.
     INCLUDE_DIR="-I ./include/ -I/Library/Frameworks/SDL2.framework/Headers -I./../common/thirdparty/old/glm"
@@ -0,0 +1,99 @@
+/** @file Benchmark.h
+ *  @brief Records frame times and writes benchmark reports.
+ *
+ *  A Benchmark records the CPU time of every frame (using the SDL
+ *  performance counter) and the GPU time of every frame (using
+ *  GL_TIME_ELAPSED queries), summarizes them into mean and
+ *  percentiles per grid size, and writes the results as JSON or CSV.
+ *
+ *  GPU query results are only read once a run has finished, so
+ *  recording never stalls the pipeline.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+#include "glm/vec3.hpp"
+
+// Summary of a single statistic in milliseconds
+struct TimingStats {
+    double mean{0.0};
+    double p50{0.0};
+    double p95{0.0};
+    double p99{0.0};
+    double min{0.0};
+    double max{0.0};
+};
+
+// Results for one grid size
+struct BenchmarkResult {
+    // Grid mode (see GridMode in Terrain.h)
+    std::string grid;
+    // Lighting mode (see LightingMode in SceneNode.h)
+    std::string lighting;
+    int gridX{0};
+    int gridZ{0};
+    // Vertex and index buffers uploaded for the plane
+    unsigned long long bufferBytes{0};
+    int frames{0};
+    // Triangles drawn per frame
+    unsigned long long trianglesPerFrame{0};
+    TimingStats cpu;
+    TimingStats gpu;
+    double trianglesPerSecond{0.0};
+};
+
+class Benchmark{
+public:
+    // Constructor
+    Benchmark();
+    // Destructor
+    ~Benchmark();
+    // Starts recording a run of at most maxFrames frames.
+    void BeginRun(int gridX, int gridZ, unsigned long long trianglesPerFrame, int maxFrames);
+    // Marks the start and end of a frame
+    void BeginFrame();
+    void EndFrame();
+    // Waits for the GPU, collects every query, and summarizes the run.
+    BenchmarkResult EndRun();
+
+    // Eye position and view direction for a frame on the fixed camera
+    // path. The path only depends on the frame number, so every run
+    // sees exactly the same views.
+    static void CameraPath(int frame, int frames, float extent, glm::vec3& eye, glm::vec3& viewDir);
+
+    // Writes all results. The driver strings identify the hardware.
+    static bool WriteJSON(const std::string& filepath, const std::vector<BenchmarkResult>& results,
+                          int width, int height, const std::string& vendor, const std::string& renderer);
+    static bool WriteCSV(const std::string& filepath, const std::vector<BenchmarkResult>& results);
+    // Prints a one line summary of a result
+    static void Print(const BenchmarkResult& result);
+    // Prints every grid and lighting mode's times and buffer sizes
+    // next to the first one's at the same size.
+    static void PrintComparison(const std::vector<BenchmarkResult>& results);
+
+private:
+    // Computes mean and percentiles of a list of samples
+    static TimingStats Summarize(std::vector<double> samples);
+
+    // Current run
+    int m_gridX;
+    int m_gridZ;
+    unsigned long long m_trianglesPerFrame;
+    // Timer start of the current frame
+    unsigned long long m_frameStart;
+    // CPU frame times in milliseconds
+    std::vector<double> m_cpuTimes;
+    // One GL_TIME_ELAPSED query per frame
+    std::vector<GLuint> m_queries;
+    int m_frame;
+};
+
+#endif
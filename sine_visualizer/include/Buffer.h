@@ -35,6 +35,13 @@ public:
                             unsigned int icount, 
                             float* vdata, 
                             unsigned int* idata );
+    // Same as above, with indices of indexSize bytes each (2 or 4).
+    void CreateBufferLayout(unsigned int stride,
+                            unsigned int vcount,
+                            unsigned int icount,
+                            float* vdata,
+                            const void* idata,
+                            unsigned int indexSize );
 
     // vcount: the number of vertices
     // icount: the number of indices
@@ -55,14 +62,17 @@ public:
                                         unsigned int icount,
                                         float* vdata,
                                         unsigned int* idata );
+    // Creates a vertex array with no buffers, for geometry that the
+    // vertex shader generates from gl_VertexID.
+    void CreateEmptyLayout();
 private:
 
     // Vertex Array Object
-    GLuint m_VAOid;
+    GLuint m_VAOid{0};
     // Vertex Buffer
-    GLuint m_vertexPositionBuffer;
+    GLuint m_vertexPositionBuffer{0};
     // Index Buffer Object
-    GLuint m_indexBufferObject;
+    GLuint m_indexBufferObject{0};
     // Stride of data (how do I get to the next vertex
     unsigned int m_stride{0};
 };
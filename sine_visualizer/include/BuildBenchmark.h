@@ -0,0 +1,71 @@
+/** @file BuildBenchmark.h
+ *  @brief Measures how fast the plane's geometry is built on the CPU.
+ *
+ *  Builds the vertex and index data of square planes of several sizes
+ *  (without uploading them, so no OpenGL context is needed) with each
+ *  available method, and reports the build time and the memory each
+ *  method peaked at.
+ *
+ *  The builder is then timed with 1 to N threads, and the output of
+ *  every thread count is checked to be identical to the serial build.
+ *
+ *  On Linux every build runs in its own forked process, so the peak
+ *  resident set size (VmHWM) of one method is not hidden by the memory
+ *  an earlier one already used.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef BUILD_BENCHMARK_H
+#define BUILD_BENCHMARK_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Result of building one plane with one method
+struct BuildResult {
+    std::string method;
+    int size{0};
+    // Threads the build used
+    int threads{1};
+    // Wall clock time of the build in milliseconds
+    double milliseconds{0.0};
+    // Growth of the peak resident set size during the build, in
+    // megabytes (0 when it could not be measured)
+    double peakMegabytes{0.0};
+    // Size of the data that would be uploaded, in megabytes
+    double dataMegabytes{0.0};
+    // Hash of the vertex and index data, to compare builds
+    unsigned long long checksum{0};
+};
+
+class BuildBenchmark{
+public:
+    // Builds a size x size plane with every method, for every size,
+    // then with the builder on 1 to maxThreads threads (0 = one per
+    // core), and prints the results. Returns false if any build failed
+    // or if any thread count built different data.
+    static bool Run(const std::vector<int>& sizes, int maxThreads, std::ostream& out);
+
+private:
+    // The ways the plane can be built
+    enum class Method {
+        // One push_back per float into five streams, then gen()
+        // copies them into the interleaved data.
+        Legacy,
+        // allocateVertices() and writing in place, by bands of rows
+        // on the ThreadPool (Terrain::buildFlatPlane())
+        Builder
+    };
+    static const char* MethodName(Method method);
+    // Builds the plane on 'threads' threads and fills the time, data
+    // size and checksum.
+    static void Build(Method method, int size, int threads, BuildResult& result);
+    // Runs Build() in a child process to also measure the peak memory.
+    static bool Measure(Method method, int size, int threads, BuildResult& result);
+    // Prints one row of the table.
+    static void Print(const BuildResult& result, std::ostream& out);
+};
+
+#endif
@@ -21,7 +21,9 @@ public:
 	// Constructor
     Camera();
 
-    void setView(glm::vec3 eyePos, glm::vec3 viewDir, glm::vec3 upVec);
+    // verbose prints the new view, which is turned off when the
+    // camera is moved every frame (e.g. the benchmark camera path).
+    void setView(glm::vec3 eyePos, glm::vec3 viewDir, glm::vec3 upVec, bool verbose = true);
     // Return a 'view' matrix with our
     // camera transformation applied.
     glm::mat4 getWorldToViewmatrix() const;
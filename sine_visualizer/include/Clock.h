@@ -0,0 +1,110 @@
+/** @file Clock.h
+ *  @brief Simulation time that stays precise for any uptime.
+ *
+ *  A float holding milliseconds since startup stops resolving a
+ *  120 Hz step after a few hours, and a float angle given to sin()
+ *  keeps losing precision as it grows. To avoid both:
+ *
+ *  - SimulationClock counts the fixed steps taken as a 64-bit
+ *    integer, and the rate as an integer number of steps per 1000
+ *    seconds. Time is the exact ratio of the two, rounded down to
+ *    the nanosecond only when it is read, so rounding never adds up.
+ *  - WaveAnimation holds every phase a SceneNode animates, so the
+ *    soak steps exactly what the nodes step.
+ *  - Phase keeps each periodic angle (e.g. the phase of a wave) in
+ *    double precision and wraps it into [0, period) on every step.
+ *    Shaders only ever receive the wrapped value, which a float
+ *    represents to within about 1e-7 radians.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <ostream>
+
+class SimulationClock{
+public:
+    // A clock that steps 'rate' times per second. The rate is kept to
+    // a thousandth of a step per second.
+    SimulationClock(double rate = 120.0);
+
+    // Advances by one fixed step.
+    inline void Step() { m_steps++; }
+    // Advances by 'steps' steps at once.
+    inline void Step(unsigned long long steps) { m_steps += steps; }
+
+    inline unsigned long long GetSteps() const { return m_steps; }
+    // Nanoseconds since the clock started, rounded down
+    unsigned long long GetTicks() const;
+    double GetSeconds() const;
+    double GetStepSeconds() const;
+
+    // Steps the animation of a SceneNode through 'days' of simulated
+    // time and checks that the wrapped phases sent to the shaders stay
+    // exact and advance by the same amount every step. Prints the
+    // results and returns false if the error exceeds the tolerance.
+    static bool Soak(double days, double rate, std::ostream& out);
+
+    static const unsigned long long TICKS_PER_SECOND = 1000000000ULL;
+
+private:
+    unsigned long long m_steps;
+    // Steps per 1000 seconds
+    unsigned long long m_stepsPerKilosecond;
+};
+
+// An angle that advances at a given rate and wraps at 'period'.
+class Phase{
+public:
+    // The default period wraps a full turn of sin() or cos().
+    Phase(double period = FULL_TURN);
+
+    // Advances by 'velocity' radians per second for 'seconds'.
+    void Advance(double velocity, double seconds);
+    // The wrapped value 'seconds' after the last step, used to draw
+    // frames that fall between two steps.
+    float Sample(double velocity, double seconds) const;
+    inline double Get() const { return m_value; }
+
+    // Wraps 'value' into [0, period).
+    static double Wrap(double value, double period);
+
+    // 2 pi in double precision
+    static constexpr double FULL_TURN = 6.283185307179586;
+
+private:
+    double m_value;
+    double m_period;
+};
+
+// The periodic motions of a SceneNode, which are stepped together.
+// Needs no OpenGL context, so the clock soak can step it too.
+class WaveAnimation{
+public:
+    WaveAnimation();
+
+    // Advances every phase by 'seconds', the wave at 'waveVelocity'
+    // radians per second.
+    void Advance(double waveVelocity, double seconds);
+    // Radians per second of a wave with the given wave period
+    static double WaveVelocity(double wavePeriod);
+
+    Phase wave;
+    Phase light;
+    Phase hue;
+    Phase saturation;
+
+    // The shaders used to receive the elapsed milliseconds / 60 as
+    // their time, so every motion advances 1000 / 60 of its units per
+    // second.
+    static constexpr double TIME_SCALE = 1000.0 / 60.0;
+    // Radians per second of the light, and of the hue and saturation
+    // of the color
+    static constexpr double LIGHT_VELOCITY = TIME_SCALE / 10.0;
+    static constexpr double HUE_VELOCITY = TIME_SCALE / 1000.0;
+    static constexpr double SATURATION_VELOCITY = TIME_SCALE / 750.0;
+};
+
+#endif
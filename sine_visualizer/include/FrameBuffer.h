@@ -4,6 +4,18 @@
  * The 'Create' function needs to be called before using the  
  * framebuffer.
  *
+ * Every post-processing effect is compiled when the framebuffer is
+ * constructed and kept in a registry by the name of its fragment
+ * shader, so switching effects only changes the program that draws
+ * the screen quad. The attachments and quad are kept as they are.
+ *
+ * Effects are drawn as a chain of passes. Each pass reads the color
+ * the previous one wrote, alternating between the scene's color
+ * target and a second one of the same size, and the last pass draws
+ * to the screen. The second target is only created once a chain
+ * needs it. Passes that would copy their input unchanged
+ * (fboFrag_standard.glsl) are skipped.
+ *
  *  @author Mike
  *  @bug No known bugs.
  *
@@ -14,6 +26,10 @@
 #include <glad/glad.h>
 #include "Shader.h" // Each Framebuffer can have a custom shader
 
+#include <map>
+#include <string>
+#include <vector>
+
 class Framebuffer{
 public:
     // Default Constructor
@@ -26,21 +42,44 @@ public:
     void Create(int width, int height);
     // Select our framebuffer
     void Bind();
-    // Update our framebuffer once per frame for any
-    // changes that may have occurred.
-    void Update();
     // Done with our framebuffer
     void Unbind();
-    // Draws the screen quad
-    void drawFBO();
+    // Draws every pass of the chain, the last one to the screen.
+    // Wireframe only applies to the last pass.
+    void drawPasses(bool wireframe);
+    // Replaces the chain with a single effect in a fragment shader,
+    // e.g. "./shaders/fboFrag_blur.glsl". Effects that were not
+    // compiled at construction are compiled now and kept.
+    void setEffect(const std::string& fboFragShader);
+    // Adds an effect to the end of the chain
+    void addPass(const std::string& fboFragShader);
+    // Passes in the chain, skipped ones included
+    inline size_t getPassCount() const { return m_passes.size(); }
+
+    // Every post-processing effect the program ships with, by name,
+    // e.g. "blur" for ./shaders/fboFrag_blur.glsl
+    static const int EFFECT_COUNT = 6;
+    static const char* const EFFECT_NAMES[EFFECT_COUNT];
+    // Whether name is one of EFFECT_NAMES
+    static bool IsEffect(const std::string& name);
+    // The fragment shader of an effect name
+    static std::string EffectShader(const std::string& name);
 private: 
+    // Compiles every effect in ./shaders into the registry
+    void loadEffects();
+    // Returns the program of an effect, compiling it if needed
+    Shader* getEffect(const std::string& fboFragShader);
+    // Rebuilds m_activePasses from m_passes
+    void updateActivePasses();
+    // Creates the second color target the passes alternate with
+    void createPingPong();
     // Creates a quad that will be overlaid on top of the screen
     // TODO: add x1,x2, etc. to draw FBO over a range in the scene.
     void setupScreenQuad(float x1,float x2, float y1, float y2);
 // public member variables
 public:
-    Shader* fboShader;
-    // Our framebuffer also needs a texture.
+    // Our framebuffer also needs a texture. It is also the first of
+    // the two color targets the passes alternate between.
     unsigned int colorBuffer_id;
 // private member variables
 private:
@@ -50,6 +89,16 @@ private:
     unsigned int rbo_id;
     // Store our screen buffer
     unsigned int quadVAO, quadVBO;
+    // The second color target and its framebuffer (0 until needed)
+    unsigned int pingPongFBO_id, pingPongBuffer_id;
+    int m_width, m_height;
+    // Programs of every effect by fragment shader, owned by
+    // ShaderCache
+    std::map<std::string, Shader*> m_effects;
+    // The chain in order, and the programs of the passes that are
+    // drawn
+    std::vector<std::string> m_passes;
+    std::vector<Shader*> m_activePasses;
 
 };
 
@@ -0,0 +1,119 @@
+/** @file FramePacer.h
+ *  @brief Paces frames and steps the simulation at a fixed rate.
+ *
+ *  FramePacer decides when a frame is presented. It can wait for
+ *  vertical sync (optionally adaptive, which tears instead of
+ *  waiting a whole extra refresh when a frame is late), wait for a
+ *  fixed target frame rate, or not wait at all. Target frame rates
+ *  sleep for most of the remaining time and spin for the last
+ *  couple of milliseconds, since sleeping alone is only accurate to
+ *  about a millisecond. Frames that take much longer than the
+ *  expected period (the target rate, or the display refresh under
+ *  vsync) are counted as missed deadlines.
+ *
+ *  FixedTimestep turns the measured frame times into a whole number
+ *  of fixed size simulation steps, so the simulation runs at the same
+ *  rate no matter how fast frames are drawn.
+ *
+ *  Both use the SDL performance counter, which is monotonic.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+#include <ostream>
+#include <string>
+
+enum class PacingMode {
+    // Present as soon as a frame is ready
+    Unlimited,
+    // Sleep then spin until the next frame of the target rate
+    TargetFPS,
+    // Wait for every vertical refresh
+    VSync,
+    // Wait for the vertical refresh unless the frame is late
+    AdaptiveVSync
+};
+
+class FramePacer{
+public:
+    // Constructor
+    FramePacer();
+
+    // Sets the pacing mode. targetFPS is used by TargetFPS. The vsync
+    // modes expect a frame every refresh of the display, so they use
+    // refreshRate when it is known (above 0) and targetFPS otherwise.
+    void Configure(PacingMode mode, double targetFPS, double refreshRate = 0.0);
+    // The swap interval the mode needs: 0, 1, or -1 (adaptive).
+    int GetSwapInterval() const;
+    // Called when adaptive vsync is not supported, so vsync is used.
+    void FallBackToVSync();
+
+    // Call at the start of every frame.
+    void BeginFrame();
+    // Waits until the frame's deadline in TargetFPS mode, and returns
+    // immediately otherwise.
+    void Wait();
+
+    // Seconds between the start of this frame and the last one
+    inline double GetDeltaSeconds() const { return m_deltaSeconds; }
+    inline unsigned long long GetFrameCount() const { return m_frameCount; }
+    inline unsigned long long GetMissedDeadlines() const { return m_missedDeadlines; }
+    inline PacingMode GetMode() const { return m_mode; }
+    // Prints the mode, the average rate, and the missed deadlines.
+    void Report(std::ostream& out) const;
+
+    // Parses "unlimited", "fps", "vsync", or "adaptive".
+    // Returns false if the name is unknown.
+    static bool ParseMode(const std::string& name, PacingMode& mode);
+    static const char* ModeName(PacingMode mode);
+
+    // A frame longer than this many periods missed its deadline.
+    static constexpr double MISSED_DEADLINE_FACTOR = 1.5;
+    // Time left before a deadline that is spun instead of slept
+    static constexpr double SPIN_MILLISECONDS = 2.0;
+
+private:
+    // Frames per second the current mode should reach
+    double expectedRate() const;
+    void updatePeriod();
+
+    PacingMode m_mode;
+    double m_targetFPS;
+    double m_refreshRate;
+    // Expected frame period in performance counter ticks
+    unsigned long long m_periodTicks;
+    // When the next frame should start in TargetFPS mode
+    unsigned long long m_deadline;
+
+    unsigned long long m_frameStart;
+    unsigned long long m_firstFrameStart;
+    double m_deltaSeconds;
+    unsigned long long m_frameCount;
+    unsigned long long m_missedDeadlines;
+};
+
+class FixedTimestep{
+public:
+    // Steps at 'rate' steps per second. At most maxSteps are taken per
+    // frame, so a long stall does not need ever more steps to catch up.
+    FixedTimestep(double rate = 120.0, int maxSteps = 8);
+
+    // Adds the elapsed time, and returns how many steps to simulate.
+    int Advance(double seconds);
+    // Length of a step in seconds
+    inline double GetStep() const { return m_step; }
+    // How far into the next step the frame is (0 to 1), which can be
+    // used to draw between the last two steps.
+    inline double GetAlpha() const { return m_accumulator / m_step; }
+
+private:
+    double m_step;
+    int m_maxSteps;
+    // Time not yet simulated, always less than a step after Advance()
+    double m_accumulator;
+};
+
+#endif
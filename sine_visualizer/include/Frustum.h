@@ -0,0 +1,57 @@
+/** @file Frustum.h
+ *  @brief Tests axis aligned boxes against a camera frustum.
+ *
+ *  The six planes are extracted from a model-view-projection matrix
+ *  (Gribb and Hartmann), so the boxes can stay in object space. Boxes
+ *  are stored as separate arrays of centers and half extents, which
+ *  lets CullBoxes() test four boxes at once with SSE. Other platforms
+ *  use the same test one box at a time.
+ *
+ *  The test is conservative: a box is only rejected when it is fully
+ *  outside one of the planes.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// Boxes as a structure of arrays
+struct BoxList {
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+
+    // Adds the box between the corners min and max.
+    void Add(const glm::vec3& min, const glm::vec3& max);
+    // Sets the half height of every box, around the same center.
+    void SetExtentY(float extent);
+    void Clear();
+    inline int Size() const { return (int)centerX.size(); }
+};
+
+class Frustum{
+public:
+    // Extracts the planes of a model-view-projection matrix.
+    explicit Frustum(const glm::mat4& modelViewProjection);
+
+    // Sets visible[i] to 1 if box i is at least partly inside the
+    // frustum, and 0 otherwise. Returns the number of visible boxes.
+    int CullBoxes(const BoxList& boxes, std::vector<unsigned char>& visible) const;
+    // Whether the box between min and max is at least partly inside.
+    bool IsVisible(const glm::vec3& min, const glm::vec3& max) const;
+
+private:
+    // ax + by + cz + d >= 0 inside, for left, right, bottom, top,
+    // near and far
+    glm::vec4 m_planes[6];
+};
+
+#endif
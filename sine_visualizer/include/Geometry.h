@@ -10,8 +10,21 @@
 #ifndef GEOMETRY_H
 #define GEOMETRY_H
 
+#include <cstddef>
 #include <vector>
 
+#include "VertexCache.h"
+
+// Attributes of an interleaved vertex. Present attributes are stored
+// in this order, matching Buffer::CreateBufferNormalMapLayout().
+enum VertexAttribute : unsigned int {
+    ATTRIBUTE_POSITION  = 1 << 0,   // 3 floats
+    ATTRIBUTE_TEXCOORD  = 1 << 1,   // 2 floats
+    ATTRIBUTE_NORMAL    = 1 << 2,   // 3 floats
+    ATTRIBUTE_TANGENT   = 1 << 3,   // 3 floats
+    ATTRIBUTE_BITANGENT = 1 << 4    // 3 floats
+};
+
 // Purpose of this class is to store vertice and triangle information
 class Geometry{
 public:
@@ -30,14 +43,51 @@ public:
     void addTexture(float s, float t);	
     // gen pushes all attributes into a single vector
     void gen();
+
+    // Builder for large meshes:
+    // Allocates vertexCount interleaved vertices holding only the
+    // given attributes (a combination of VertexAttribute), which are
+    // then written in place through getVertex(). Replaces addVertex(),
+    // addTexture(), and gen(), and allocates exactly once.
+    void allocateVertices(unsigned int vertexCount, unsigned int attributes);
+    // Number of floats per vertex
+    inline unsigned int getStride() { return m_stride; }
+    // Offset of an attribute within a vertex in floats (the attribute
+    // must be part of the layout).
+    unsigned int getAttributeOffset(VertexAttribute attribute);
+    // The first float of vertex i
+    inline float* getVertex(unsigned int i) { return allData.data() + (size_t)i * m_stride; }
     // Functions for working with Indices
     // Creates a triangle from 3 indicies
     // When a triangle is made, the tangents and bi-tangents are also
     // computed
     void makeTriangle(unsigned int vert0, unsigned int vert1, unsigned int vert2);  
+    // Replaces the indices with triangle strips over a grid of
+    // xVertices x zVertices vertices, separated by restart indices.
+    // 16-bit indices are used whenever every vertex fits. Bands of
+    // rows are built in parallel by the ThreadPool.
+    void makeGridStrips(int xVertices, int zVertices);
 
     unsigned int getIndicesSize();
     unsigned int* getIndicesData();
+    // Indices of either size, for uploading to an index buffer.
+    const void* getIndexBytes();
+    // Size of one index in bytes (2 or 4)
+    unsigned int getIndexTypeSize();
+    // Whether the indices contain restart indices
+    inline bool usesPrimitiveRestart() { return m_primitiveRestart; }
+    // Whether the indices are a triangle list rather than strips
+    inline bool isTriangleList() { return m_triangleList; }
+    inline void setTriangleList(bool triangleList) { m_triangleList = triangleList; }
+
+    // The indices as a triangle list (3 per triangle). Strips are split
+    // at restart indices, keep their winding, and lose their degenerate
+    // triangles.
+    std::vector<unsigned int> getTriangleList();
+    // Replaces the indices with a triangle list ordered for the GPU's
+    // post-transform vertex cache (see VertexCache). The index size
+    // stays the same.
+    void optimizeVertexCache(int cacheSize = VertexCache::DEFAULT_CACHE_SIZE);
 
 private:
     // All data stores all of the vertexPositons, coordinates, normals, etc.
@@ -53,6 +103,13 @@ private:
 
     // The indices for a indexed-triangle mesh
     std::vector<unsigned int> indices;
+    // Layout of allData when built with allocateVertices()
+    unsigned int m_attributes{0};
+    unsigned int m_stride{0};
+    // Used instead of indices when every vertex fits in 16 bits
+    std::vector<unsigned short> shortIndices;
+    bool m_primitiveRestart{false};
+    bool m_triangleList{false};
 };
 
 
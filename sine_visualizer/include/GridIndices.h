@@ -0,0 +1,94 @@
+/** @file GridIndices.h
+ *  @brief Builds triangle strip indices for a grid of vertices.
+ *
+ *  A grid of xVertices x zVertices vertices, stored row by row, is
+ *  drawn as one triangle strip per pair of rows. Strips are separated
+ *  by a restart index (the largest value of the index type), which
+ *  ends the strip without the degenerate triangles the rows used to
+ *  be joined with. Any ratio of X to Z works.
+ *
+ *  The index type is a template parameter, so 16-bit indices (half
+ *  the memory and bandwidth of 32-bit ones) can be chosen whenever
+ *  every vertex fits. Fits() tells whether a grid does.
+ *
+ *  Where each row's strip starts only depends on the row, so
+ *  BuildRows() can write any band of rows on its own, and bands can
+ *  be built by different threads into the same array.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef GRID_INDICES_H
+#define GRID_INDICES_H
+
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+template <typename IndexType>
+class GridStripBuilder{
+public:
+    static_assert(std::is_unsigned<IndexType>::value, "Grid indices must be unsigned");
+
+    // Ends the current strip. Matches the fixed restart index OpenGL
+    // uses for this type.
+    static constexpr IndexType RESTART_INDEX = std::numeric_limits<IndexType>::max();
+
+    // Whether every vertex of the grid can be indexed without using
+    // the restart index.
+    static bool Fits(int xVertices, int zVertices) {
+        return (unsigned long long)xVertices * (unsigned long long)zVertices <= (unsigned long long)RESTART_INDEX;
+    }
+
+    // Number of indices Build() writes, including the restarts.
+    static size_t IndexCount(int xVertices, int zVertices) {
+        if (xVertices < 2 || zVertices < 2)
+            return 0;
+        size_t rows = zVertices - 1;
+        return rows * 2 * xVertices + (rows - 1);
+    }
+
+    // Position in the index array of the first index of a strip row
+    // (after the restart that separates it from the previous row).
+    static size_t RowStart(int xVertices, int row) {
+        return (size_t)row * (2 * (size_t)xVertices + 1);
+    }
+
+    // Writes the strips of rows [firstRow, lastRow) of an array of
+    // IndexCount() indices starting at 'out'. Only the part of the
+    // array those rows own is written.
+    static void BuildRows(int xVertices, int zVertices, int firstRow, int lastRow, IndexType* out) {
+        if (xVertices < 2 || zVertices < 2)
+            return;
+        for (int z = firstRow; z < lastRow && z < zVertices - 1; ++z) {
+            IndexType* rowOut = out + RowStart(xVertices, z);
+            if (z > 0)
+                rowOut[-1] = RESTART_INDEX;
+            IndexType row = (IndexType)((size_t)z * xVertices);
+            IndexType nextRow = (IndexType)(row + xVertices);
+            // Alternate between the two rows. The winding matches the
+            // strips the grid was drawn with before.
+            for (int x = 0; x < xVertices; ++x) {
+                *rowOut++ = (IndexType)(row + x);
+                *rowOut++ = (IndexType)(nextRow + x);
+            }
+        }
+    }
+
+    // Writes IndexCount() indices to 'out'.
+    static void Build(int xVertices, int zVertices, IndexType* out) {
+        BuildRows(xVertices, zVertices, 0, zVertices - 1, out);
+    }
+
+    static std::vector<IndexType> Build(int xVertices, int zVertices) {
+        std::vector<IndexType> indices(IndexCount(xVertices, zVertices));
+        Build(xVertices, zVertices, indices.data());
+        return indices;
+    }
+};
+
+template <typename IndexType>
+constexpr IndexType GridStripBuilder<IndexType>::RESTART_INDEX;
+
+#endif
@@ -0,0 +1,44 @@
+/** @file HeadlessContext.h
+ *  @brief Creates an OpenGL context without a window.
+ *
+ *  Uses EGL with an offscreen pbuffer surface so the program can
+ *  render on machines without a display (including Mesa llvmpipe).
+ *  The pbuffer acts as the default framebuffer, so the renderer
+ *  does not need to know whether it is running headless or not.
+ *
+ *  Only supported on Linux.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <string>
+
+class HeadlessContext{
+public:
+    // Constructor
+    HeadlessContext();
+    // Destroys the surface and context, and terminates EGL.
+    ~HeadlessContext();
+    // Creates a width x height offscreen surface and an OpenGL core
+    // context of the requested version, and makes it current.
+    // Returns false and fills error if anything fails.
+    bool Create(int width, int height, int majorVersion, int minorVersion, std::string& error);
+    // Presents the frame (a no-op for pbuffers, but it keeps the
+    // frame boundaries explicit for the driver).
+    void SwapBuffers();
+    // 0 disables waiting for vertical sync, 1 enables it.
+    void SetSwapInterval(int interval);
+    // Used to load OpenGL functions with GLAD.
+    static void* GetProcAddress(const char* name);
+private:
+    // EGL handles are stored as void* so EGL headers do not
+    // leak into every file that includes this one.
+    void* m_display;
+    void* m_surface;
+    void* m_context;
+};
+
+#endif
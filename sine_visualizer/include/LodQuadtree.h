@@ -0,0 +1,87 @@
+/** @file LodQuadtree.h
+ *  @brief Chooses the level of detail of each part of the plane.
+ *
+ *  Continuous distance-based LOD (CDLOD, Strugar 2009). The plane is
+ *  covered by a quadtree whose leaves are patches of patchQuads x
+ *  patchQuads quads of size 1, and each level up doubles the size of
+ *  the quads. Every level has a range that doubles with the level. A
+ *  node is drawn at its own level if the eye is within its range but
+ *  outside the range of the level below, otherwise its children are
+ *  tried. A quadrant whose child is too far is drawn by the parent.
+ *
+ *  Within the last part of its range, the vertex shader slides every
+ *  odd vertex of a patch onto the next coarser grid (see lodMorph in
+ *  vert.glsl), so the levels meet without cracks and change without
+ *  popping.
+ *
+ *  Each level covers a ring of roughly the same number of patches,
+ *  so the number of triangles mostly depends on the range and patch
+ *  size, and grows only with the log of the plane size.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef LOD_QUADTREE_H
+#define LOD_QUADTREE_H
+
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Frustum.h"
+
+// A node to draw with the shared patch mesh
+struct LodPatch {
+    // Corner with the smallest x and z
+    float x;
+    float z;
+    // Side covered by the whole patch mesh
+    float size;
+    int level;
+    // -1 draws the whole patch. 0 to 3 only draw one quadrant:
+    // bit 0 is the upper half of x, and bit 1 of z.
+    int quadrant;
+};
+
+class LodQuadtree{
+public:
+    LodQuadtree();
+    // Covers a plane of xSegments x zSegments vertices, centered the
+    // same way Terrain builds it. patchQuads must be a power of two.
+    void Create(int xSegments, int zSegments, int patchQuads);
+    // Sets the range of the finest level (0 = 3 patches).
+    void SetBaseRange(float range);
+
+    // Fills patches with the nodes to draw for an eye in object
+    // space. Nodes are culled against the frustum with their box
+    // grown by maxHeight above and below the plane.
+    void Select(const glm::vec3& eye, const Frustum& frustum, float maxHeight, std::vector<LodPatch>& patches) const;
+
+    inline int GetLevels() const { return m_levels; }
+    inline int GetPatchQuads() const { return m_patchQuads; }
+    // Distances the morph of a level to the next one starts and ends at
+    glm::vec2 GetMorphRange(int level) const;
+
+    // Where the morph starts, as a fraction of the band between the
+    // range of the level below and the level's own range
+    static constexpr float MORPH_START = 0.7f;
+
+private:
+    // Adds the node or its children. Returns false if the node is out
+    // of the range of its level, so its parent has to draw its area.
+    bool SelectNode(float x, float z, float size, int level, const glm::vec3& eye,
+                    const Frustum& frustum, float maxHeight, std::vector<LodPatch>& patches) const;
+
+    int m_patchQuads;
+    int m_levels;
+    // Corner and side of the root node
+    glm::vec2 m_rootCorner;
+    float m_rootSize;
+    // Bounds of the plane's vertices
+    glm::vec2 m_planeMin;
+    glm::vec2 m_planeMax;
+    // Range of every level, finest first
+    std::vector<float> m_ranges;
+};
+
+#endif
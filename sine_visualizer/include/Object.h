@@ -15,6 +15,7 @@
 #include "Buffer.h"
 #include "Constants.h"
 #include "Geometry.h"
+#include "Shader.h"
 #include "Texture.h"
 #include "Util.h"
 
@@ -30,16 +31,34 @@ public:
     // Object Constructor
     Object();
     // Object destructor
-    ~Object();
+    virtual ~Object();
     // Initialization routine
     // The method can be overridden by other primitives.
     virtual void init();
     // How to draw the object
     virtual void render();
+    // Sets any uniforms the object's shader needs to draw it.
+    // Called with the shader bound. An object may keep the shader to
+    // set uniforms from cull() and render() too, so it must live until
+    // setUniforms() is called with another one (the programs of a
+    // SceneNode are kept by ShaderCache until shutdown).
+    virtual void setUniforms(Shader& /*shader*/) {}
+    // Called before the object is drawn with the object space to clip
+    // space transform, the camera position in object space, and how
+    // far the vertex shader may displace the object vertically, so
+    // parts outside the view can be skipped or drawn in less detail.
+    virtual void cull(const glm::mat4& /*modelViewProjection*/, const glm::vec3& /*eye*/, float /*maxHeight*/) {}
+    // Whether render() draws patches, which need the tessellation
+    // shaders to be linked into the object's shader.
+    virtual bool usesTessellation() { return false; }
     // Loads a specific texture
     void LoadTexture(std::string fileName);
 
     inline void setRenderMode(std::string mode) { m_renderMode = mode; }; 
+    // Number of indices (or vertices) drawn by render()
+    virtual unsigned int getIndexCount() { return geometry.getIndicesSize(); }
+    // Number of triangles drawn by render() as a triangle strip
+    virtual unsigned long long getTriangleCount() { return (getIndexCount() > 2) ? getIndexCount() - 2 : 0; }
 protected:
     // Helper method for when we are ready to draw or update our object
     void Bind();
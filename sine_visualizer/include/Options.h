@@ -0,0 +1,135 @@
+/** @file Options.h
+ *  @brief Command line options for the visualizer.
+ *
+ *  Every value that used to be typed in at startup (window size,
+ *  plane dimensions, wave parameters) can be passed on the command
+ *  line instead, which allows running the program unattended.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <string>
+#include <vector>
+
+// Purpose:
+// Stores every setting that can be passed in through argv.
+// Values left at 0 are prompted for when running interactively.
+struct ProgramOptions {
+    // Window (or offscreen surface) dimensions
+    int windowWidth{0};
+    int windowHeight{0};
+    // Plane dimensions
+    int terrainX{0};
+    int terrainZ{0};
+
+    // Initial wave settings
+    float amplitude{100.0f};
+    float waveNumber{0.5f};
+    float wavePeriod{50.0f};
+
+    // "yAxis", "xyAxis", or "flat"
+    std::string planeMode{"yAxis"};
+    // "triStrip" or "points"
+    std::string renderMode{"triStrip"};
+    // "vertexBuffer", "procedural", "tiles", "lod", "tessellation",
+    // "projected" or "instanced" (see GridMode in Terrain.h)
+    std::string gridMode{"vertexBuffer"};
+    // "tangent" or "world" (see LightingMode in SceneNode.h)
+    std::string lighting{"tangent"};
+    // Quads along each side of a tile in the "tiles" grid mode
+    int tileSize{64};
+    // Quads along each side of the patch mesh in the "lod" grid mode
+    int lodPatch{32};
+    // Range of the finest LOD level (0 = 3 patches)
+    float lodRange{0.0f};
+    // Quads along each side of a patch in the "tessellation" grid mode
+    int tessPatch{32};
+    // Shortest tessellated segment, in pixels
+    float tessPixels{8.0f};
+    // Largest distance allowed between a tessellated segment and the
+    // wave, in plane units
+    float tessError{0.5f};
+    // Pixels between the vertices of the "projected" grid mode
+    int projectedCell{4};
+    // Quads along each side of the patch in the "instanced" grid mode
+    int instancePatch{64};
+    // Draws the vertex buffer, tile and instanced grids as triangle
+    // lists ordered for the vertex cache
+    bool vertexCache{false};
+    // Post-processing effect names in the order they run, e.g.
+    // "grayscale" for ./shaders/fboFrag_grayscale.glsl
+    std::vector<std::string> effects{"standard"};
+    // Directory linked shader programs are saved to, and loaded from
+    // on the next start (empty = always compile)
+    std::string shaderCacheDir{"./shader_cache"};
+
+    // Optional texture and height map (positional arguments)
+    std::string texturePath;
+    std::string terrainPath;
+
+    // Headless mode renders offscreen without a window and exits.
+    bool headless{false};
+    // Number of frames rendered in headless mode
+    int frames{1};
+    // When set, the last headless frame is written to this PPM file
+    std::string outputPath;
+
+    // Benchmark mode renders a fixed camera path at several grid
+    // sizes with no frame delay and no vsync, then exits.
+    bool benchmark{false};
+    // Square grid sizes to benchmark
+    std::vector<int> benchSizes{256, 1024};
+    // Grid modes to benchmark at every size (empty = only gridMode)
+    std::vector<std::string> benchGrids;
+    // Lighting modes to benchmark with every grid mode (empty = only
+    // lighting)
+    std::vector<std::string> benchLighting;
+    // Frames measured per grid size, after the warmup frames
+    int benchFrames{300};
+    int benchWarmup{30};
+    // Result files (either can be left empty)
+    std::string benchJSON;
+    std::string benchCSV;
+
+    // Records CPU and GPU timers for every render pass
+    bool profile{false};
+    // Seconds between reports (0 only reports on demand)
+    double profileInterval{1.0};
+    // CSV file every report is appended to
+    std::string profileFile;
+
+    // "vsync", "adaptive", "fps", or "unlimited". Left empty, windows
+    // use vsync and headless runs are unlimited.
+    std::string pacing;
+    // Frame rate of the "fps" mode, and the expected display rate
+    double targetFPS{60.0};
+    // Fixed simulation steps per second
+    double simulationRate{120.0};
+
+    // Plane sizes to time the CPU geometry build of (empty = none)
+    std::vector<int> buildBenchSizes;
+    // Threads that build geometry, and the most the build benchmark
+    // scales to (0 = one per core)
+    int buildThreads{0};
+    // Plane sizes to report the vertex cache efficiency of (empty = none)
+    std::vector<int> cacheReportSizes;
+
+    // Days of simulated time to soak the clock for (0 = no soak)
+    double clockSoakDays{0.0};
+
+    // Chrome trace_event JSON file the timeline is written to
+    std::string traceFile;
+    // Number of events kept in the timeline
+    int traceCapacity{0};
+};
+
+// Fills options from argv. Returns false if the program should exit,
+// either because of invalid arguments or because help was requested.
+bool parseOptions(int argc, char** argv, ProgramOptions& options);
+// Prints every supported argument.
+void printUsage(const char* executable);
+
+#endif
@@ -0,0 +1,172 @@
+/** @file Profiler.h
+ *  @brief CPU and GPU timers for each stage of a frame.
+ *
+ *  Sections of code are timed by placing a PROFILE_SCOPE("name")
+ *  at the top of a block. Each section records its CPU time with the
+ *  SDL performance counter and its GPU time with a pair of
+ *  GL_TIMESTAMP queries (timestamps, unlike GL_TIME_ELAPSED, can be
+ *  nested). Queries are kept in a ring of frames and are only read
+ *  once the GPU has finished with them, so reading never stalls.
+ *
+ *  Rolling averages can be queried through GetStats(), and can be
+ *  printed to the console and/or appended to a stat file at a fixed
+ *  interval.
+ *
+ *  The same sections are recorded on the timeline of Trace when it
+ *  is enabled. Both are disabled by default, in which case a timer
+ *  only costs a couple of branches.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <glad/glad.h>
+
+#include "Trace.h"
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Averages of a section in milliseconds
+struct ProfileStats {
+    double cpuAverage{0.0};
+    double gpuAverage{0.0};
+    double cpuLast{0.0};
+    double gpuLast{0.0};
+    // Number of frames in the averages
+    int samples{0};
+};
+
+class Profiler{
+public:
+    // The one profiler shared by every system
+    static Profiler& Get();
+    // Releases the query objects. Must be called while the OpenGL
+    // context still exists.
+    void Shutdown();
+
+    void SetEnabled(bool enabled);
+    inline bool IsEnabled() const { return m_enabled; }
+    // Prints a report every interval seconds (0 disables it).
+    inline void SetReportInterval(double seconds) { m_reportInterval = seconds; }
+    // Appends every report to a file as CSV.
+    void SetStatFile(const std::string& filepath);
+
+    // Returns the id of a section, creating it the first time.
+    int GetSectionID(const std::string& name);
+
+    // Call at the very start and end of every frame.
+    void BeginFrame();
+    void EndFrame();
+    // Used by ScopedTimer
+    void BeginSection(int id);
+    void EndSection(int id);
+
+    // Rolling averages of a section
+    ProfileStats GetStats(const std::string& name) const;
+    std::vector<std::string> GetSectionNames() const;
+    // Prints the averages of every section
+    void Report(std::ostream& out) const;
+
+    // Number of frames averaged
+    static const int WINDOW = 120;
+    // Frames of GPU queries in flight before they are read
+    static const int FRAMES_IN_FLIGHT = 3;
+
+private:
+    Profiler();
+    ~Profiler();
+    Profiler(const Profiler&) = delete;
+    Profiler& operator=(const Profiler&) = delete;
+
+    // Fixed size window of the latest samples
+    struct RollingAverage {
+        double samples[WINDOW] = {};
+        double sum{0.0};
+        int count{0};
+        int next{0};
+        double last{0.0};
+        void Add(double sample);
+        inline double Average() const { return (count > 0) ? sum / count : 0.0; }
+    };
+
+    struct Section {
+        std::string name;
+        // Nesting depth, so recursive sections are only timed once
+        int depth{0};
+        unsigned long long cpuStart{0};
+        // Record of the currently open GPU timestamp pair
+        int openRecord{0};
+        // Accumulated this frame
+        double cpuFrame{0.0};
+        bool timedThisFrame{false};
+        RollingAverage cpu;
+        RollingAverage gpu;
+    };
+
+    // A begin/end timestamp pair for one section
+    struct GpuRecord {
+        int section;
+        GLuint begin;
+        GLuint end;
+    };
+
+    // The queries issued during one frame
+    struct FrameQueries {
+        std::vector<GLuint> pool;
+        std::vector<GpuRecord> records;
+        size_t used{0};
+        // The most recently issued query of the frame
+        GLuint lastQuery{0};
+        bool pending{false};
+    };
+
+    // Takes an unused query from the current frame's pool
+    GLuint NextQuery();
+    // Reads the results of a frame if they are ready.
+    // Returns false without waiting if they are not.
+    bool Collect(FrameQueries& frame);
+    // Prints or writes the report if the interval elapsed
+    void MaybeReport();
+
+    bool m_enabled;
+    // Start of the current frame, for the timeline
+    unsigned long long m_frameStart;
+    std::vector<Section> m_sections;
+    FrameQueries m_frames[FRAMES_IN_FLIGHT];
+    int m_currentFrame;
+
+    double m_reportInterval;
+    unsigned long long m_lastReport;
+    unsigned long long m_startTime;
+    std::ofstream m_statFile;
+};
+
+// Times a section for as long as it is in scope, or until Stop().
+class ScopedTimer{
+public:
+    ScopedTimer(int id);
+    ~ScopedTimer();
+    // Ends the section before the end of the scope.
+    void Stop();
+private:
+    int m_id;
+    // Whether the profiler was enabled when the timer started
+    bool m_active;
+    // Counter value at the start, 0 when the timeline is disabled
+    unsigned long long m_traceStart;
+};
+
+// Times the rest of the enclosing block as the section 'name'.
+// The section id is only looked up the first time.
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profileSection, __LINE__) = Profiler::Get().GetSectionID(name); \
+    ScopedTimer PROFILE_CONCAT(profileTimer, __LINE__)(PROFILE_CONCAT(profileSection, __LINE__))
+
+#endif
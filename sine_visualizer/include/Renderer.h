@@ -41,6 +41,8 @@ public:
     
     // TODO:(Optional)  write getter/setter methods
     void setFBOShader(std::string fboFragShader);
+    // Adds a post-processing effect to the end of the chain
+    void addFBOShader(std::string fboFragShader);
 
     inline void setGeometryWireframe(bool wireframe) { m_geometryWireframe = wireframe; }
     
@@ -30,8 +30,17 @@
 #include <fstream>
 #include <vector>
 
+#include "Benchmark.h"
+#include "Clock.h"
+#include "FramePacer.h"
+#include "HeadlessContext.h"
+#include "Options.h"
+#include "Profiler.h"
 #include "Renderer.h"
+#include "ShaderCache.h"
+#include "ThreadPool.h"
 #include "Terrain.h"
+#include "UniformBuffer.h"
 
 // Purpose:
 // This class sets up a full graphics program using SDL
@@ -42,18 +51,45 @@ public:
     SDLGraphicsProgram(int w, int h);   // Default constructor
     SDLGraphicsProgram(int w, int h, std::string terrain_filepath);
     SDLGraphicsProgram(int w, int h, std::string terrain_filepath, std::string texture_filepath);
+    SDLGraphicsProgram(const ProgramOptions& options);
     // Desctructor
     ~SDLGraphicsProgram();
 
     void init();
     // loop that runs forever
     void loop();
+    // Renders the requested number of frames offscreen and returns.
+    // Returns false if there is no headless context to render to.
+    bool runHeadless();
+    // Renders the fixed benchmark camera path at every requested
+    // grid size, and writes the results.
+    bool runBenchmark();
     // Get Pointer to Window
     SDL_Window* getSDLWindow();
     // Helper Function to Query OpenGL information.
     void getOpenGLVersionInfo();
 
 private:
+    // Creates the terrain, its scene node, and places the camera.
+    // Plane dimensions that were not passed in are prompted for.
+    void setupScene();
+    // Builds the scene for a terrainX x terrainZ plane.
+    void buildScene(int terrainX, int terrainZ);
+    // Deletes the terrain and its scene node.
+    void destroyScene();
+    // Presents the frame on the window or headless surface.
+    void swapBuffers();
+    // Sets the swap interval the pacing mode needs.
+    void applyPacing();
+    // Runs every fixed simulation step that fits in 'seconds'.
+    void stepSimulation(double seconds);
+    // Writes the default framebuffer to a PPM file.
+    void saveFrame(const std::string& filepath);
+
+    // Settings passed in from the command line
+    ProgramOptions m_options;
+    // Offscreen context used instead of a window in headless mode
+    HeadlessContext* m_headlessContext;
     // The window we'll be rendering to
     SDL_Window* gWindow ;
     // OpenGL context
@@ -61,6 +97,17 @@ private:
 	// The Renderer responsible for drawing objects
 	// in OpenGL (Or whatever Renderer you choose!)
 	Renderer* renderer;
+    // The plane and the node that draws it
+    Terrain* m_terrain;
+    SceneNode* m_terrainNode;
+    // Height the camera is placed at for each view
+    float m_cameraHeight;
+    // Decides when frames are presented
+    FramePacer m_pacer;
+    // Steps the waves at a fixed rate
+    FixedTimestep m_simulation;
+    // Total simulated time
+    SimulationClock m_clock;
     // String to store the currently loaded FBO fragment
     // shader when manually selecting it.
     std::string fboFragShader;
@@ -24,6 +24,7 @@
 #include "glm/gtc/matrix_transform.hpp"
 
 #include "Camera.h"
+#include "Clock.h"
 #include "Constants.h"
 #include "Object.h"
 #include "Shader.h"
@@ -31,12 +32,24 @@
 #include "Util.h"
 
 
+// Space the lights are computed in:
+// Tangent passes every light to the fragment shader in the tangent
+// space of the vertex (13 point lights are 39 floats per vertex).
+// World only passes the world position and normal, and the fragment
+// shader reads the lights from its uniforms.
+// Each mode is a variant of the shaders, built with or without
+// WORLD_LIGHTING defined.
+enum class LightingMode {
+    Tangent,
+    World
+};
+
 class SceneNode{
 public:
     // A SceneNode is created by taking
     // a pointer to an object.
     SceneNode(Object* ob);
-    SceneNode(Object* ob, int xSegs, int zSegs);
+    SceneNode(Object* ob, int xSegs, int zSegs, LightingMode lighting = LightingMode::Tangent);
     // Our destructor takes care of destroying
     // all of the children within the node.
     // Now we do not have to manage deleting
@@ -49,6 +62,12 @@ public:
     void Draw();
     // Updates the current SceneNode
     void Update(glm::mat4 projectionMatrix, Camera* camera);
+    // Advances the simulation of this node and its children by one
+    // fixed step (in seconds).
+    void Advance(double deltaTime);
+    // Time past the last step (in seconds) the next frame is drawn
+    // at, so frames between steps still move smoothly.
+    inline void setTimeOffset(double timeOffset) { m_timeOffset = timeOffset; }
     // Returns the local transformation transform
     // Remember that local is local to an object, where it's center is the origin.
     Transform& getLocalTransform();
@@ -60,8 +79,14 @@ public:
     inline void setAmplitude(float amplitude) { m_amplitude = amplitude; }
     inline void setWaveNumber(float waveNumber) { m_waveNumber = waveNumber; }
     inline void setWavePeriod(float wavePeriod) { m_wavePeriod = wavePeriod; }
+    // The point lights are spread over the plane.
+    inline void setPlaneSize(int xSegs, int zSegs) { m_xSegments = xSegs; m_zSegments = zSegs; }
+    // Parses "tangent" or "world". Returns false if the name is unknown.
+    static bool ParseLightingMode(const std::string& name, LightingMode& mode);
 
-    Shader myShader;
+    // The variant of the shaders for the current plane mode, chosen by
+    // Update()
+    Shader* myShader;
     // TODO:
     // Protected members are accessible by anything
     // that we inherit from, as well as ?
@@ -85,15 +110,29 @@ private:
     int m_xSegments;
     int m_zSegments;
 
-    float m_elapsedTime;
-    float m_currentTime;
-    float m_previousTime;
+    // Each periodic motion is kept as a wrapped phase, so only
+    // small angles reach the shaders however long the program runs.
+    WaveAnimation m_animation;
+    double m_timeOffset;
 
     float m_amplitude;
     float m_waveNumber;
     float m_wavePeriod;
 
     std::string m_planeMode;
+
+    // Radians per second the wave travels at
+    double waveVelocity() const;
+
+    // Chosen when the shaders are built
+    LightingMode m_lighting;
+
+    // Ring slot of the uniform blocks written by the last Update()
+    int m_uniformSlot;
+
+    // One variant of the shaders per plane mode (flat, yAxis, xyAxis),
+    // built with PLANE_MODE defined to 0, 1, and 2
+    Shader* m_planeModeShaders[3];
 };
 
 #endif
@@ -3,6 +3,13 @@
  *  
  *  Additionally has functions for setting various uniforms.
  *
+ *  When a program links, its active uniforms are listed once with
+ *  glGetActiveUniform into a table of locations and types. Callers can
+ *  keep a UniformHandle into the table instead of passing a name every
+ *  frame, and each uniform keeps a copy of the last value sent, so
+ *  setting the same value again makes no OpenGL call at all. Uniforms
+ *  in the shared blocks are set through UniformBuffer instead.
+ *
  *  @author Mike
  *  @bug No known bugs.
  */
@@ -13,6 +20,9 @@
 #include <string>
 #include <iostream>
 #include <fstream>
+#include <map>
+#include <unordered_map>
+#include <vector>
 #include <glad/glad.h>
 
 #if defined(LINUX) || defined(MINGW)
@@ -21,6 +31,21 @@
     #include <SDL.h>
 #endif
 
+// Names and values to #define in a shader, ordered by name so the
+// same set always builds the same source
+typedef std::map<std::string, std::string> ShaderDefines;
+
+// A uniform of a linked program, kept by callers so that setting it
+// needs no name lookup. Only valid for the shader and link it was
+// found in (see Shader::getGeneration()).
+struct UniformHandle {
+    // Index into the shader's uniform table, -1 when the program has
+    // no active uniform of that name
+    int index{-1};
+    // The link the index belongs to
+    unsigned int generation{0};
+};
+
 class Shader{
 public:
     // Shader constructor
@@ -33,19 +58,69 @@ public:
     void Unbind() const;
     // Load a shader
     std::string LoadShader(const std::string& fname);
+    // Returns a loaded shader with "#define name value" for every
+    // define right after its #version line, for the #if blocks of the
+    // shader to see. Empty values define just the name.
+    static std::string AddDefines(const std::string& source, const ShaderDefines& defines);
     // Create a Shader from a loaded vertex and fragment shaders,
-    // or from loaded vertex, geometry, and fragment shaders.
+    // from loaded vertex, geometry, and fragment shaders, or from
+    // loaded vertex, tessellation control, tessellation evaluation,
+    // and fragment shaders (which needs OpenGL 4.0).
     void CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource);
     void CreateShader(const std::string& vertexShaderSource, const std::string& geometryShaderSource, const std::string& fragmentShaderSource);
+    void CreateShader(const std::string& vertexShaderSource, const std::string& tessControlShaderSource,
+                      const std::string& tessEvaluationShaderSource, const std::string& fragmentShaderSource);
+    // Create a Shader from a binary of a linked program saved with
+    // getBinary(), instead of from source (needs OpenGL 4.1). Returns
+    // false without creating anything if the driver does not accept
+    // it, as another driver or version would not.
+    bool CreateShaderFromBinary(GLenum format, const std::vector<char>& binary);
+    // Gets the binary of the linked program. Returns false if the
+    // driver cannot give one.
+    bool getBinary(GLenum& format, std::vector<char>& binary) const;
     // return the shader id
     GLuint getID() const;
+    // Changes every time a program is created, in any shader, so kept
+    // handles can tell they belong to an older link.
+    unsigned int getGeneration() const;
+    // Finds an active uniform, or an element of an active uniform
+    // array, once.
+    UniformHandle getUniform(const std::string& name) const;
     // Set our uniforms for our shader.
     void setUniformMatrix4fv(const GLchar* name, const GLfloat* value);
+    void setUniformMatrix3fv(const GLchar* name, const GLfloat* value);
+    void setUniform4f(const GLchar* name, float v0, float v1, float v2, float v3);
 	void setUniform3f(const GLchar* name, float v0, float v1, float v2);
+    void setUniform2f(const GLchar* name, float v0, float v1);
     void setUniform1i(const GLchar* name, int value);
+    void setUniform2i(const GLchar* name, int v0, int v1);
     void setUniform1f(const GLchar* name, float value);
+    // The same, through a kept handle. The shader must be bound.
+    void setUniformMatrix4fv(const UniformHandle& uniform, const GLfloat* value);
+    void setUniformMatrix3fv(const UniformHandle& uniform, const GLfloat* value);
+    void setUniform4f(const UniformHandle& uniform, float v0, float v1, float v2, float v3);
+    void setUniform3f(const UniformHandle& uniform, float v0, float v1, float v2);
+    void setUniform2f(const UniformHandle& uniform, float v0, float v1);
+    void setUniform1i(const UniformHandle& uniform, int value);
+    void setUniform2i(const UniformHandle& uniform, int v0, int v1);
+    void setUniform1f(const UniformHandle& uniform, float value);
 
 private:
+    // An active uniform and the last value sent to it
+    struct UniformInfo {
+        GLint location;
+        GLenum type;
+        bool hasValue;
+        // Floats or ints, up to a mat4
+        GLint value[16];
+    };
+    // Lists the active uniforms of a newly linked program.
+    void reflect(GLuint program);
+    // Returns the uniform to send a value to, or nullptr when the
+    // handle is stale or missing, the type does not match, or the value
+    // is the one already sent.
+    UniformInfo* update(const UniformHandle& uniform, GLenum type, const void* value, size_t size);
+
     // Compiles loaded shaders
     unsigned int CompileShader(unsigned int type, const std::string& source);
     // Makes sure shaders 'linked' successfully
@@ -57,6 +132,10 @@ private:
     void Log(const char* system, const char* message);
     // The unique shaderID
     GLuint shaderID;
+    // Active uniforms of the program, and their indices by name
+    std::vector<UniformInfo> m_uniforms;
+    std::unordered_map<std::string, int> m_uniformIndices;
+    unsigned int m_generation;
 };
 
 #endif
@@ -0,0 +1,111 @@
+/** @file ShaderCache.h
+ *  @brief Builds each variant of a shader program once and keeps it.
+ *
+ *  A variant is a set of shader files built with a set of #defines
+ *  added to every stage (see Shader::AddDefines()). Values that would
+ *  otherwise be branched on for every vertex, such as the plane mode,
+ *  are defined instead, so the compiler removes the code the variant
+ *  does not use and unrolls loops of a defined length.
+ *
+ *  Variants are kept by the names of their files and their defines, so
+ *  asking for one again returns the program already built. Files are
+ *  only read once. A line #include "name" in a shader is replaced by
+ *  the file it names, relative to the shader's directory, so stages can
+ *  share code.
+ *
+ *  Linked programs are also saved to a directory with
+ *  glGetProgramBinary() (OpenGL 4.1), named by a hash of their sources
+ *  (defines included) and of the vendor, renderer, and version of the
+ *  driver. The next start loads them with glProgramBinary() instead of
+ *  compiling. A binary that is missing, corrupt, or refused by the
+ *  driver is rebuilt from source and saved again.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef SHADER_CACHE_H
+#define SHADER_CACHE_H
+
+#include "Shader.h"
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+// Files of the stages of a program. Stages that are not used are left
+// empty; the tessellation stages are used together or not at all.
+struct ShaderFiles {
+    std::string vertex;
+    std::string tessControl;
+    std::string tessEvaluation;
+    std::string fragment;
+};
+
+class ShaderCache{
+public:
+    // The one cache shared by every program
+    static ShaderCache& Get();
+    // Deletes every program. Must be called while the OpenGL context
+    // still exists.
+    void Shutdown();
+
+    // Directory program binaries are saved to and loaded from. It is
+    // created when the first binary is saved. Empty turns saving and
+    // loading binaries off.
+    void SetBinaryDirectory(const std::string& directory);
+
+    // Returns the variant of the files with the defines, building it
+    // the first time it is asked for.
+    Shader* GetProgram(const ShaderFiles& files, const ShaderDefines& defines);
+    // Variants built so far
+    size_t GetSize() const;
+
+    // Prints how long every variant built so far took to build, then
+    // builds each one again, first from source as a first start would
+    // (cold), then from its saved binary (warm), and prints the time
+    // each took. The variants in use and the saved binaries are not
+    // touched. Returns false if there is nothing to build.
+    bool StartupReport(std::ostream& out);
+
+private:
+    ShaderCache();
+    ~ShaderCache();
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    // A program with what it was built from
+    struct Variant {
+        ShaderFiles files;
+        ShaderDefines defines;
+        std::unique_ptr<Shader> program;
+        // How long building it took, and whether it was loaded from
+        // its binary
+        double buildMilliseconds{0.0};
+        bool fromBinary{false};
+    };
+
+    // Builds a variant, from its binary when there is one the driver
+    // accepts and useBinary is set, and from source otherwise, saving
+    // the binary if save is set. fromBinary tells which one happened.
+    std::unique_ptr<Shader> build(const ShaderFiles& files, const ShaderDefines& defines,
+                                  bool useBinary, bool save, bool& fromBinary);
+    // Returns the contents of a file, reading it the first time, with
+    // every #include "name" line replaced by the file it names.
+    const std::string& source(Shader& shader, const std::string& file);
+    // Whether the driver can save and load program binaries
+    bool binariesSupported();
+    // File the binary of the sources with a hash is saved to
+    std::string binaryPath(uint64_t hash) const;
+    bool loadBinary(Shader& program, uint64_t hash);
+    void saveBinary(const Shader& program, uint64_t hash);
+
+    std::unordered_map<std::string, Variant> m_programs;
+    std::unordered_map<std::string, std::string> m_sources;
+    std::string m_binaryDirectory;
+    // -1 until the driver has been asked
+    int m_binariesSupported;
+};
+
+#endif
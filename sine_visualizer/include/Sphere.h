@@ -82,6 +82,11 @@ void Sphere::init(){
             }
         }
 
+        // The indices are a triangle list. Order it for the vertex cache,
+        // rows of the sphere otherwise repeat every vertex transform.
+        geometry.setTriangleList(true);
+        geometry.optimizeVertexCache();
+
         // Finally generate a simple 'array of bytes' that contains
         // everything for our buffer to work with.
         geometry.gen();
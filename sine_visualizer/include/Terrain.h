@@ -13,28 +13,210 @@
 #include "Texture.h"
 #include "Shader.h"
 #include "Image.h"
+#include "Frustum.h"
+#include "LodQuadtree.h"
+#include <ostream>
 #include <vector>
 #include <string>
 
+// How the grid reaches the vertex shader
+enum class GridMode {
+    // Positions are uploaded in a vertex buffer, and drawn with an
+    // index buffer.
+    VertexBuffer,
+    // Nothing is uploaded. The vertex shader computes each position
+    // from gl_VertexID and the grid dimensions.
+    Procedural,
+    // The plane is split into square tiles, each with its own buffers
+    // and bounding box. Tiles outside the camera's view are not drawn.
+    Tiles,
+    // One patch mesh is drawn many times, with each patch's size
+    // chosen by its distance to the camera (see LodQuadtree.h).
+    Lod,
+    // A coarse grid of patches is drawn, and the tessellation shaders
+    // split each edge according to its size on screen and how much
+    // the wave bends along it (needs OpenGL 4.0).
+    Tessellation,
+    // A grid fixed to the screen is projected onto the plane through
+    // the camera, so its cost follows the resolution and the plane
+    // reaches the horizon whatever its dimensions.
+    Projected,
+    // One small patch mesh is drawn once per patch of the plane with
+    // a single instanced draw call, so the buffers do not grow with
+    // the plane.
+    Instanced
+};
+
+// Tiles and triangles of the plane drawn in the last culled frame
+struct CullStats {
+    int tiles{0};
+    int tilesDrawn{0};
+    unsigned long long triangles{0};
+    unsigned long long trianglesDrawn{0};
+};
+
 class Terrain : public Object {
 public:
     // Default constructor
-    Terrain(int xSegs, int zSegs);
+    // tileSize is the number of quads along each side of a tile in
+    // GridMode::Tiles, of the patch mesh in GridMode::Lod (rounded
+    // up to a power of two), or of a patch in GridMode::Tessellation and
+    // GridMode::Instanced.
+    // optimizeVertexCache draws the vertex buffer, tile and instanced
+    // grids as triangle lists ordered for the vertex cache instead of
+    // strips (see VertexCache).
+    Terrain(int xSegs, int zSegs, GridMode gridMode = GridMode::VertexBuffer, int tileSize = DEFAULT_TILE_SIZE,
+            bool optimizeVertexCache = false);
     // Alternate constructor
     Terrain(int xSegs, int zSegs, std::string fileName);
     ~Terrain();
     // override the initilization routine.
     void init();
+    // Draws procedural grids without any buffers.
+    void render() override;
+    // Sets the grid mode and dimensions.
+    void setUniforms(Shader& shader) override;
+    // Finds the tiles inside the view, or selects the LOD patches.
+    // Every box reaches maxHeight above and below the plane, to hold
+    // the wave.
+    void cull(const glm::mat4& modelViewProjection, const glm::vec3& eye, float maxHeight) override;
+    // Range of the finest LOD level (0 = 3 patches)
+    inline void setLodRange(float range) { m_lod.SetBaseRange(range); }
+    // Shortest tessellated segment in pixels, and largest distance in
+    // object space allowed between a segment and the wave
+    inline void setTessellation(float pixels, float error) { m_tessPixels = pixels; m_tessError = error; }
+    // Pixels between the vertices of the projected grid
+    inline void setProjectedCell(int pixels) { m_projectedCell = pixels; }
+    // Changes the plane's dimensions without rebuilding any buffer.
+    // Only the procedural, projected and instanced grid modes can be
+    // resized. Returns false for the others.
+    bool resize(int xSegs, int zSegs);
+    // Bytes of vertex and index buffers uploaded for the plane
+    inline unsigned long long getBufferBytes() { return m_bufferBytes; }
+    // Whether render() draws patches for the tessellation shaders
+    bool usesTessellation() override { return m_gridMode == GridMode::Tessellation; }
+    unsigned int getIndexCount() override;
+    unsigned long long getTriangleCount() override;
+    // Triangles of the whole plane at full resolution
+    unsigned long long getPlaneTriangleCount();
+    inline GridMode getGridMode() { return m_gridMode; }
+    inline const CullStats& getCullStats() { return m_lastCull; }
+    // Prints the tiles and triangles culled, or the LOD patches and
+    // triangles drawn, in the last frame and on average, or the
+    // triangles the tessellator generated. Prints nothing for the
+    // other grid modes.
+    void printCullStats(std::ostream& out);
+    // Parses "vertexBuffer", "procedural", "tiles", "lod",
+    // "tessellation", "projected" or "instanced".
+    // Returns false if the name is unknown.
+    static bool ParseGridMode(const std::string& name, GridMode& mode);
+    // Fills geometry with the flat xSegments x zSegments plane and its
+    // strip indices, using every thread of the ThreadPool.
+    static void buildFlatPlane(Geometry& geometry, int xSegments, int zSegments);
     inline int getXSegments() { return xSegments; }
     inline int getZSegments() { return zSegments; }
 
+    static const int DEFAULT_TILE_SIZE = 64;
+    static const int DEFAULT_PROJECTED_CELL = 4;
+    // Largest instanced patch whose vertices fit 16-bit indices
+    static const int MAX_INSTANCE_PATCH = 128;
+    // Most vertices along a side of the plane. The vertex count of a
+    // procedural strip over the whole plane still fits an int.
+    static const int MAX_SEGMENTS = 16384;
+
 private:
+    // Builds one buffer and bounding box per tile.
+    void initTiles();
+    // Builds the shared LOD patch mesh and the quadtree.
+    void initLod();
+    // Builds the coarse grid of patches to tessellate.
+    void initTessellation();
+    // Builds the patch mesh drawn once per instance.
+    void initInstanced();
+    // Instances along X and Z
+    int instancePatchesX();
+    int instancePatchesZ();
+    // Part of clip space (min x, y, max x, y) the projected grid must
+    // cover so the wave between nearHeight and farHeight fills the
+    // screen.
+    glm::vec4 projectedRange(const glm::mat4& modelViewProjection, const glm::mat4& projectorInverse,
+                             float nearHeight, float farHeight);
+
     // data
+    // Every member has its default here, so the constructors only set
+    // what they are given.
     int xSegments;
     int zSegments;
+    GridMode m_gridMode{GridMode::VertexBuffer};
+    bool m_optimizeVertexCache{false};
+
+    // A tile of the plane with its own vertex and index buffers
+    struct Tile {
+        Buffer* buffer;
+        unsigned int indexCount;
+        GLenum indexType;
+        unsigned long long triangles;
+    };
+    int m_tileSize{DEFAULT_TILE_SIZE};
+    std::vector<Tile> m_tiles;
+    // Bounds of every tile, in the same order as m_tiles
+    BoxList m_tileBounds;
+    // Result of the last cull() (1 = drawn)
+    std::vector<unsigned char> m_tileVisible;
+    CullStats m_lastCull;
+    // Totals over every culled frame, for the averages
+    unsigned long long m_culledFrames{0};
+    unsigned long long m_tilesCulled{0};
+    unsigned long long m_trianglesCulled{0};
+
+    LodQuadtree m_lod;
+    // Patches selected by the last cull()
+    std::vector<LodPatch> m_lodPatches;
+    glm::vec3 m_lodEye{0.0f};
+    // Indices of the whole patch mesh, and where each quadrant's are
+    unsigned int m_lodIndexCount{0};
+    unsigned int m_quadrantOffset[4]{};
+    unsigned int m_quadrantCount[4]{};
+    unsigned long long m_trianglesDrawn{0};
+    // The shader render() sets the per patch uniforms of, from the
+    // last setUniforms(). Not owned; see Object::setUniforms().
+    Shader* m_shader{nullptr};
+    // Handles of the grid uniforms in m_shader, found again whenever
+    // it is linked again
+    struct GridUniforms {
+        unsigned int generation{0};
+        UniformHandle gridMode, gridSize, instancePatch;
+        UniformHandle viewportSize, tessPixels, tessError;
+        UniformHandle lodEye, lodPatch, lodMorph;
+        UniformHandle projectorInverse, projectorHeight, projectorRange;
+    };
+    GridUniforms m_uniforms;
+
+    // Indices of the tessellation patches, 4 per patch
+    unsigned int m_tessIndexCount{0};
+    float m_tessPixels{8.0f};
+    float m_tessError{0.5f};
+    // Queries counting the triangles the tessellator generates. One
+    // is read while the other one counts, so reading never waits.
+    GLuint m_tessQueries[2]{0, 0};
+    int m_tessQuery{0};
+    bool m_tessQueryPending[2]{false, false};
+    unsigned long long m_trianglesGenerated{0};
+    unsigned long long m_tessFrames{0};
+
+    // Vertices of the projected grid along X and Y of the screen,
+    // every m_projectedCell pixels of the viewport
+    int m_projectedCell{DEFAULT_PROJECTED_CELL};
+    int m_projectedX{0};
+    int m_projectedZ{0};
+
+    // Indices of the instanced patch mesh
+    unsigned int m_instanceIndexCount{0};
+    // Size of every buffer uploaded
+    unsigned long long m_bufferBytes{0};
 
     // Store the height in a multidimensional array
-    int* heightData;
+    int* heightData{nullptr};
 
     // Textures for the terrain
     // Terrains are often 'multitextured' and have multiple textures.
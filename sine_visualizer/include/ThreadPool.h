@@ -0,0 +1,72 @@
+/** @file ThreadPool.h
+ *  @brief A fixed set of worker threads for splitting loops across cores.
+ *
+ *  ParallelFor() splits a range into bands, and every worker (plus the
+ *  calling thread) takes bands until none are left. Bands never
+ *  overlap, so tasks that write to disjoint parts of a preallocated
+ *  buffer need no locking, and produce the same output for any number
+ *  of threads.
+ *
+ *  The pool is shared by the whole program, like the Profiler. It
+ *  starts with no workers (everything runs on the calling thread)
+ *  until SetThreadCount() is called.
+ *
+ *  @author David Cardona
+ *  @bug ParallelFor() must not be called from inside a task.
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool{
+public:
+    // The one pool shared by every system
+    static ThreadPool& Get();
+
+    // Uses 'threads' threads in total, including the calling thread
+    // (1 runs everything serially, 0 uses every core).
+    void SetThreadCount(int threads);
+    inline int GetThreadCount() const { return (int)m_workers.size() + 1; }
+
+    // Calls task(begin, end) for bands of [0, count) of at least
+    // 'grain' items each, and returns once every band is done.
+    void ParallelFor(int count, int grain, const std::function<void(int, int)>& task);
+
+private:
+    ThreadPool();
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Stops and joins every worker.
+    void StopWorkers();
+    void WorkerLoop();
+    // Takes bands of the current task until none are left.
+    void RunBands();
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    // Signals the workers that a task (or stop) is ready
+    std::condition_variable m_wake;
+    // Signals the caller that every worker finished the task
+    std::condition_variable m_done;
+    bool m_stop;
+    // Incremented for every task, so workers notice new ones
+    unsigned long long m_generation;
+    int m_busyWorkers;
+
+    // The current task
+    const std::function<void(int, int)>* m_task;
+    int m_count;
+    int m_bandSize;
+    int m_bands;
+    std::atomic<int> m_nextBand;
+};
+
+#endif
@@ -0,0 +1,75 @@
+/** @file Trace.h
+ *  @brief Timeline of the sections timed in every frame.
+ *
+ *  While enabled, every PROFILE_SCOPE section and every frame is
+ *  recorded as a timestamped event in a fixed size ring buffer, so
+ *  the latest events are always available without growing memory.
+ *  The buffer can be written at any time as Chrome trace_event JSON,
+ *  which opens in chrome://tracing or Perfetto (ui.perfetto.dev).
+ *
+ *  Unlike the averages of the Profiler, the timeline shows the
+ *  single slow frame and which section caused it.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+class Trace{
+public:
+    // The one timeline shared by every system
+    static Trace& Get();
+
+    // Allocates room for 'capacity' events and starts recording.
+    // Once full, the oldest events are overwritten. Must not be
+    // called while other threads are recording.
+    void Start(size_t capacity);
+    // Stops recording. The recorded events are kept.
+    void Stop();
+    inline bool IsEnabled() const { return m_enabled; }
+
+    // Records a section of the Profiler that started and ended at the
+    // given SDL performance counter values.
+    void Record(int section, unsigned long long startTicks, unsigned long long endTicks);
+    // Records a frame boundary.
+    void RecordFrame(unsigned long long startTicks, unsigned long long endTicks);
+
+    // Number of events currently held (at most the capacity).
+    size_t GetEventCount() const;
+    // Writes the held events, oldest first, as Chrome trace_event JSON.
+    bool WriteJSON(const std::string& filepath) const;
+
+    // Default number of events kept
+    static const size_t DEFAULT_CAPACITY = 65536;
+
+private:
+    Trace();
+    Trace(const Trace&) = delete;
+    Trace& operator=(const Trace&) = delete;
+
+    // A complete ("X") event. section is -1 for frames.
+    struct Event {
+        unsigned long long start;
+        unsigned long long end;
+        int section;
+        unsigned int thread;
+    };
+
+    // Small id of the calling thread (0 for the first thread to record)
+    static unsigned int ThreadID();
+
+    // Read by every thread that records
+    std::atomic<bool> m_enabled;
+    std::vector<Event> m_events;
+    // Total number of events recorded since Start()
+    std::atomic<unsigned long long> m_written;
+    // Counter value that timestamps are relative to
+    unsigned long long m_startTicks;
+};
+
+#endif
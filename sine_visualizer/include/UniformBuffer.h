@@ -0,0 +1,160 @@
+/** @file UniformBuffer.h
+ *  @brief std140 uniform blocks shared by every shader program.
+ *
+ *  The uniforms every program reads are grouped into three blocks,
+ *  laid out with std140 so the structs below match the shaders byte
+ *  for byte:
+ *  FrameBlock   - the camera and the directional light, which change
+ *                 every frame.
+ *  ObjectBlock  - the transforms, wave, and color of one object.
+ *  LightsBlock  - the colors and positions of the lights, which only
+ *                 change with the size of the plane.
+ *
+ *  The frame and object blocks are written to a ring of slots in one
+ *  buffer, one slot per SceneNode::Update(), with a single unsynchronized
+ *  map. The ring is split into segments, and EndFrame() places a fence
+ *  after the draws that read each segment written that frame. Writing
+ *  the first slot of a segment waits for its fence, so a slot is never
+ *  written while the GPU may still read it. The ring is large enough
+ *  that the fence has almost always passed. The lights block lives in
+ *  its own buffer and is only uploaded when it changes.
+ *
+ *  Shader binds the blocks of every program it links to the binding
+ *  points below, so binding a slot is all a draw needs.
+ *
+ *  @author David Cardona
+ *  @bug No known bugs.
+ */
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include "glm/glm.hpp"
+
+#include <cstddef>
+
+// Must match NR_POINT_LIGHTS in the shaders
+const int NUMBER_OF_POINT_LIGHTS = 13;
+
+// Binding points of the blocks
+enum UniformBinding : GLuint {
+    FRAME_BLOCK_BINDING = 0,
+    OBJECT_BLOCK_BINDING = 1,
+    LIGHTS_BLOCK_BINDING = 2
+};
+
+// layout(std140) uniform FrameBlock
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    // xyz, a vec3 takes 16 bytes
+    glm::vec4 viewPos;
+    // Direction of the circling directional light (xyz)
+    glm::vec4 lightDirection;
+};
+
+// layout(std140) uniform ObjectBlock
+struct ObjectBlock {
+    glm::mat4 model;
+    glm::mat4 modelViewProjection;
+    // Each column of a mat3 takes a vec4.
+    glm::vec4 normalMatrix[3];
+    glm::vec3 diffuseColor;
+    float amplitude;
+    float waveNumber;
+    float wavePeriod;
+    float wavePhase;
+    float materialShininess;
+};
+
+// std140 layout of the DirLight struct of the shaders
+struct DirLightData {
+    glm::vec3 color;
+    float ambientIntensity;
+    float specularStrength;
+    float padding[3];
+};
+
+// std140 layout of the PointLight struct of the shaders
+struct PointLightData {
+    glm::vec3 position;
+    float padding;
+    glm::vec3 color;
+    float ambientIntensity;
+    float specularStrength;
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+// layout(std140) uniform LightsBlock
+struct LightsBlock {
+    DirLightData dirLight;
+    PointLightData pointLights[NUMBER_OF_POINT_LIGHTS];
+};
+
+// Offsets std140 gives the members in the shaders
+static_assert(offsetof(FrameBlock, viewPos) == 128 && sizeof(FrameBlock) == 160, "FrameBlock does not match std140");
+static_assert(offsetof(ObjectBlock, normalMatrix) == 128 && offsetof(ObjectBlock, diffuseColor) == 176 &&
+              offsetof(ObjectBlock, amplitude) == 188 && offsetof(ObjectBlock, materialShininess) == 204 &&
+              sizeof(ObjectBlock) == 208, "ObjectBlock does not match std140");
+static_assert(sizeof(DirLightData) == 32 && sizeof(PointLightData) == 48 &&
+              offsetof(LightsBlock, pointLights) == 32, "LightsBlock does not match std140");
+
+class UniformBuffer{
+public:
+    // The one ring shared by every SceneNode
+    static UniformBuffer& Get();
+    // Releases the buffers. Must be called while the OpenGL context
+    // still exists.
+    void Shutdown();
+
+    // Binds the blocks a linked program uses to their binding points.
+    static void BindBlocks(GLuint program);
+
+    // Writes the blocks to the next slot of the ring, and returns the
+    // slot for Bind().
+    int Write(const FrameBlock& frame, const ObjectBlock& object);
+    // Binds the frame and object blocks of a slot.
+    void Bind(int slot);
+    // Uploads the lights if they differ from the last ones uploaded.
+    void SetLights(const LightsBlock& lights);
+    // Fences the segments written since the last call. Called once
+    // the draws that read them have been issued.
+    void EndFrame();
+
+    // Slots in the ring, one per object drawn in each frame the GPU
+    // is behind. A frame can use at most RING_SLOTS - SEGMENT_SLOTS.
+    static const int RING_SLOTS = 64;
+    // Slots covered by one fence
+    static const int SEGMENT_SLOTS = 16;
+
+private:
+    UniformBuffer();
+    ~UniformBuffer();
+    UniformBuffer(const UniformBuffer&) = delete;
+    UniformBuffer& operator=(const UniformBuffer&) = delete;
+
+    // Creates the buffers the first time they are needed.
+    void create();
+    // Waits until the GPU is done with a segment.
+    void waitForSegment(int segment);
+
+    GLuint m_ring;
+    GLuint m_lights;
+    // Offset of the object block within a slot, and the size of a
+    // slot, rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    GLsizeiptr m_objectOffset;
+    GLsizeiptr m_slotSize;
+    int m_nextSlot;
+    // Fence of each segment (0 when none is pending), and a bit for
+    // every segment written since the last EndFrame()
+    GLsync m_fences[RING_SLOTS / SEGMENT_SLOTS];
+    unsigned int m_writtenSegments;
+    bool m_warnedFull;
+    LightsBlock m_lastLights;
+    bool m_lightsUploaded;
+};
+
+#endif
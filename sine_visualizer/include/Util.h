@@ -5,6 +5,7 @@
 
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <limits>
 #include <memory>
 #include <random>
@@ -53,9 +54,4 @@ inline float clamp(float x, float min, float max) {
     return x;
 }
 
-inline char* strToCharArray(std::string str) {
-	char* charArray = new char[str.length() + 1];
-	return strcpy(charArray, str.c_str());
-}
-
 #endif
\ No newline at end of file
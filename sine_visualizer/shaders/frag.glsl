@@ -1,20 +1,20 @@
 // ===============================================================
 #version 330 core
 
-#define NR_POINT_LIGHTS 13
+// NR_POINT_LIGHTS is defined when the shader is built (see
+// SceneNode::init()).
 
 // ============== STRUCTS ==============
 
-// Struct to store a directional light
+// Struct to store a directional light. Its direction circles every
+// frame, so it is part of FrameBlock.
 struct DirLight {
-    vec3 direction;
-
     vec3 color;
     float ambientIntensity;
     float specularStrength;
 };
 
-// Struct to store a point light
+// Struct to store a point light.
 struct PointLight {
     vec3 position;
 
@@ -27,21 +27,48 @@ struct PointLight {
     float quadratic;
 };
 
-// ============== UNIFORMS ==============
-// Set uniforms from SceneNode::update()
-uniform float material_shininess;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform float time;
+// ============== UNIFORM BLOCKS ==============
+// Shared by every program and set from SceneNode::Update(). The
+// std140 layout matches the structs in UniformBuffer.h.
+layout(std140) uniform FrameBlock {
+    mat4 view;              // World to View.
+    mat4 projection;        // View to Projection.
+    vec3 viewPos;           // Camera position in world space.
+    vec3 lightDirection;    // Direction of the directional light.
+};
+
+layout(std140) uniform ObjectBlock {
+    mat4 model;                 // Model to World.
+    mat4 modelViewProjection;   // Model to Projection.
+    mat3 normalMatrix;          // Transpose of the inverse of the model.
+    vec3 diffuseColor;          // Cycles through hues on the CPU.
+    // Values to control the rendered wave.
+    float amplitude;
+    float waveNumber;
+    float wavePeriod;
+    // Phases are wrapped on the CPU in double precision, so they stay
+    // small and precise however long the program runs.
+    float wavePhase;            // Offset that moves the wave.
+    float material_shininess;
+};
+
+layout(std140) uniform LightsBlock {
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+};
 
 // ============== IN ==============
 // Import data from Vertex Shader
 in VS_OUT {
     vec3 Normal;
+#ifdef WORLD_LIGHTING
+    vec3 FragPos;
+#else
     vec3 tanFragPos;
     vec3 tanViewPos;
     vec3 tanDirLightPos;
     vec3 tanPointLightsPos[NR_POINT_LIGHTS];
+#endif
 } fs_in;
 
 // ============== OUT ==============
@@ -50,33 +77,41 @@ out vec4 FragColor;
 
 
 // Function Prototypes
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
-vec3 CalcPointLight(PointLight light, vec3 tanLightPos, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 HSVtoRGB(vec3 color);
+vec3 CalcDirLight(DirLight light, vec3 lightDirection, vec3 normal, vec3 viewDir);
+vec3 CalcPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir);
 
 
 void main() {
     // Properties
     vec3 norm = normalize(fs_in.Normal);
-    
-    vec3 hsvColor = vec3(tan(time / 1000.0f), (cos(time / 750.0f) + 1) / 2, 1.0f);
-    vec3 diffuseColor = HSVtoRGB(hsvColor) * 0.7f;
 
+
+#ifdef WORLD_LIGHTING
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+
+    // ====== CALCULATE DIRECTIONAL LIGHT
+    vec3 Lighting = CalcDirLight(dirLight, lightDirection, norm, viewDir);
+
+    // ====== CALCULATE POINT LIGHTS
+    for (int i = 0; i < NR_POINT_LIGHTS; i++)
+        Lighting += CalcPointLight(pointLights[i], pointLights[i].position, norm, fs_in.FragPos, viewDir);
+#else
     vec3 viewDir = normalize(fs_in.tanViewPos - fs_in.tanFragPos);
 
     // ====== CALCULATE DIRECTIONAL LIGHT
-    vec3 Lighting = CalcDirLight(dirLight, norm, viewDir);
+    vec3 Lighting = CalcDirLight(dirLight, fs_in.tanDirLightPos, norm, viewDir);
 
     // ====== CALCULATE POINT LIGHTS
     for (int i = 0; i < NR_POINT_LIGHTS; i++)
         Lighting += CalcPointLight(pointLights[i], fs_in.tanPointLightsPos[i], norm, fs_in.tanFragPos, viewDir);
+#endif
 
     FragColor = vec4(diffuseColor * clamp(Lighting, 0.1f, 1.0f), 1.0f);
 }
 
-vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
+vec3 CalcDirLight(DirLight light, vec3 lightDirection, vec3 normal, vec3 viewDir) {
     // Find the direction
-    vec3 lightDir = normalize(-fs_in.tanDirLightPos);
+    vec3 lightDir = normalize(-lightDirection);
     // Diffuse shading
     float diffImpact = max(dot(normal, lightDir), 0.0);
     // Specular shading
@@ -91,9 +126,9 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir) {
 }
 
 // Calculate the color of a point light
-vec3 CalcPointLight(PointLight light, vec3 tanLightPos, vec3 normal, vec3 fragPos, vec3 viewDir) {
+vec3 CalcPointLight(PointLight light, vec3 lightPos, vec3 normal, vec3 fragPos, vec3 viewDir) {
     // Find the direction
-    vec3 lightDir = normalize(tanLightPos - fragPos);
+    vec3 lightDir = normalize(lightPos - fragPos);
     // Diffuse shading
     float diffImpact = max(dot(normal, lightDir), 0.0);
     // Specular shading
@@ -101,7 +136,7 @@ vec3 CalcPointLight(PointLight light, vec3 tanLightPos, vec3 normal, vec3 fragPo
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material_shininess);
 
     // Attenuation
-    float distance = length(tanLightPos - fragPos);
+    float distance = length(lightPos - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
 
     // Combine results
@@ -116,11 +151,4 @@ vec3 CalcPointLight(PointLight light, vec3 tanLightPos, vec3 normal, vec3 fragPo
     return (ambient + diffuse + specular);
 }
 
-// Function to convert colors in HSV format to colors in RGB format.
-// REF: https://gamedev.stackexchange.com/questions/59797/glsl-shader-change-hue-saturation-brightness
-vec3 HSVtoRGB(vec3 color){
-    vec4 K = vec4(1.0, 2.0 / 3.0, 1.0 / 3.0, 3.0);
-    vec3 p = abs(fract(color.xxx + K.xyz) * 6.0 - K.www);
-    return color.z * mix(K.xxx, clamp(p - K.xxx, 0.0, 1.0), color.y);
-}
 // ==================================================================
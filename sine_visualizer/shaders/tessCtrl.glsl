@@ -0,0 +1,128 @@
+// ==================================================================
+#version 400 core
+
+// Each patch is one quad of the coarse grid.
+layout(vertices = 4) out;
+
+// PLANE_MODE is defined when the shader is built (see
+// SceneNode::init()).
+
+// ============== UNIFORM BLOCKS ==============
+// Shared with the other stages and set from SceneNode::Update(). The
+// std140 layout matches ObjectBlock in UniformBuffer.h.
+layout(std140) uniform ObjectBlock {
+    mat4 model;                 // Model to World.
+    mat4 modelViewProjection;   // Model to Projection.
+    mat3 normalMatrix;          // Transpose of the inverse of the model.
+    vec3 diffuseColor;          // Cycles through hues on the CPU.
+    // Values to control the rendered wave.
+    float amplitude;
+    float waveNumber;
+    float wavePeriod;
+    // Phases are wrapped on the CPU in double precision, so they stay
+    // small and precise however long the program runs.
+    float wavePhase;            // Offset that moves the wave.
+    float material_shininess;
+};
+
+// ============== UNIFORMS ==============
+uniform vec2 viewportSize;  // In pixels.
+
+uniform float tessPixels;   // Shortest segment worth drawing, in pixels.
+uniform float tessError;    // Largest gap allowed between the wave and
+                            // a segment, in object space units.
+
+// ============== IN / OUT ==============
+in vec3 tcPosition[];
+out vec3 tePosition[];
+
+// Most segments per edge OpenGL guarantees
+const float MAX_LEVEL = 64.0f;
+
+vec2 phaseGradient(vec2 pos);
+float edgeLevel(vec3 a, vec3 b);
+bool outsideView();
+
+void main() {
+    tePosition[gl_InvocationID] = tcPosition[gl_InvocationID];
+
+    if (gl_InvocationID == 0) {
+        if (outsideView()) {
+            // A level of 0 discards the patch.
+            gl_TessLevelOuter[0] = 0.0f;
+            gl_TessLevelOuter[1] = 0.0f;
+            gl_TessLevelOuter[2] = 0.0f;
+            gl_TessLevelOuter[3] = 0.0f;
+            gl_TessLevelInner[0] = 0.0f;
+            gl_TessLevelInner[1] = 0.0f;
+            return;
+        }
+        // Corners are (u, v) = (0, 0), (1, 0), (1, 1) and (0, 1).
+        // Neighbouring patches compute the level of a shared edge from
+        // the same two corners, so their edges always match.
+        gl_TessLevelOuter[0] = edgeLevel(tcPosition[0], tcPosition[3]);   // u = 0
+        gl_TessLevelOuter[1] = edgeLevel(tcPosition[0], tcPosition[1]);   // v = 0
+        gl_TessLevelOuter[2] = edgeLevel(tcPosition[1], tcPosition[2]);   // u = 1
+        gl_TessLevelOuter[3] = edgeLevel(tcPosition[3], tcPosition[2]);   // v = 1
+        gl_TessLevelInner[0] = max(gl_TessLevelOuter[1], gl_TessLevelOuter[3]);
+        gl_TessLevelInner[1] = max(gl_TessLevelOuter[0], gl_TessLevelOuter[2]);
+    }
+}
+
+// Gradient of the phase of the wave in calculateSine() (see
+// tessEval.glsl). Its length along an edge is the local wavenumber.
+vec2 phaseGradient(vec2 pos) {
+#if PLANE_MODE == 1
+    return vec2(waveNumber / 50, 0.0f);
+#else
+    float k = waveNumber / 100;
+    return k * k * vec2(pos.y, pos.x);
+#endif
+}
+
+// Segments an edge needs: enough for the wave to bend smoothly, but
+// no more than can be seen on screen.
+float edgeLevel(vec3 a, vec3 b) {
+    // A segment of length h of a sine with amplitude A and wavenumber
+    // k is at most A (k h)^2 / 8 away from the wave. Flat planes and
+    // edges across the wave fronts need no segments at all.
+    float curvatureLevel = 1.0f;
+#if PLANE_MODE != 0
+    vec2 edge = b.xz - a.xz;
+    float len = length(edge);
+    float k = abs(dot(phaseGradient((a.xz + b.xz) * 0.5f), edge / max(len, 1e-6f)));
+    curvatureLevel = len * k * sqrt(abs(amplitude) / (8.0f * tessError));
+#endif
+
+    float screenLevel = MAX_LEVEL;
+    vec4 clipA = modelViewProjection * vec4(a, 1.0f);
+    vec4 clipB = modelViewProjection * vec4(b, 1.0f);
+    // Edges that reach behind the camera are only limited by the wave.
+    if (clipA.w > 0.0f && clipB.w > 0.0f) {
+        vec2 pixels = (clipA.xy / clipA.w - clipB.xy / clipB.w) * 0.5f * viewportSize;
+        screenLevel = length(pixels) / tessPixels;
+    }
+    return clamp(min(curvatureLevel, screenLevel), 1.0f, MAX_LEVEL);
+}
+
+// Whether the patch's box, grown by the amplitude of the wave, is
+// completely outside one of the planes of the view.
+bool outsideView() {
+    vec4 corners[8];
+    for (int i = 0; i < 4; i++) {
+        corners[i]     = modelViewProjection * vec4(tcPosition[i] + vec3(0.0f, amplitude, 0.0f), 1.0f);
+        corners[i + 4] = modelViewProjection * vec4(tcPosition[i] - vec3(0.0f, amplitude, 0.0f), 1.0f);
+    }
+    for (int axis = 0; axis < 3; axis++) {
+        bool allBelow = true;
+        bool allAbove = true;
+        for (int i = 0; i < 8; i++) {
+            allBelow = allBelow && corners[i][axis] < -corners[i].w;
+            allAbove = allAbove && corners[i][axis] > corners[i].w;
+        }
+        if (allBelow || allAbove)
+            return true;
+    }
+    return false;
+}
+// ==================================================================
@@ -0,0 +1,19 @@
+// ==================================================================
+#version 400 core
+
+// The corners of each patch are interpolated across the tessellated
+// quad, and the wave is applied to every generated vertex.
+layout(quads, fractional_even_spacing, ccw) in;
+
+// ============== IN ==============
+in vec3 tePosition[];
+
+// Structs, uniform blocks, outputs, and the wave itself.
+#include "wave.glsl"
+
+void main() {
+    vec2 uv = gl_TessCoord.xy;
+    emitWaveVertex(mix(mix(tePosition[0], tePosition[1], uv.x),
+                       mix(tePosition[3], tePosition[2], uv.x), uv.y));
+}
+// ==================================================================
@@ -0,0 +1,16 @@
+// ==================================================================
+#version 400 core
+
+// ============== VBO LAYOUTS ==============
+layout(location=0)in vec3 position;
+
+// ============== OUT ==============
+// The corners of the coarse patches are passed on as they are. The
+// wave is only applied once the patches are tessellated (see
+// tessEval.glsl).
+out vec3 tcPosition;
+
+void main() {
+    tcPosition = position;
+}
+// ==================================================================
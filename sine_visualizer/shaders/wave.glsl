@@ -0,0 +1,186 @@
+// ==================================================================
+// The wave shared by the vertex shader and the tessellation evaluation
+// shader. Both stages #include it after their own inputs and call
+// emitWaveVertex() with the position on the flat plane. ShaderCache
+// replaces the #include line with this file.
+//
+// PLANE_MODE and NR_POINT_LIGHTS are defined when the shader is built
+// (see SceneNode::init()), so only the code for one plane mode is
+// compiled, and the light loops have a constant count.
+
+// ============== STRUCTS ==============
+
+// Struct to store a directional light. Its direction circles every
+// frame, so it is part of FrameBlock.
+struct DirLight {
+    vec3 color;
+    float ambientIntensity;
+    float specularStrength;
+};
+
+// Struct to store a point light.
+struct PointLight {
+    vec3 position;
+
+    vec3 color;
+    float ambientIntensity;
+    float specularStrength;
+
+    float constant;
+    float linear;
+    float quadratic;
+};
+
+// ============== UNIFORM BLOCKS ==============
+// Shared by every program and set from SceneNode::Update(). The
+// std140 layout matches the structs in UniformBuffer.h.
+layout(std140) uniform FrameBlock {
+    mat4 view;              // World to View.
+    mat4 projection;        // View to Projection.
+    vec3 viewPos;           // Camera position in world space.
+    vec3 lightDirection;    // Direction of the directional light.
+};
+
+layout(std140) uniform ObjectBlock {
+    mat4 model;                 // Model to World.
+    mat4 modelViewProjection;   // Model to Projection.
+    mat3 normalMatrix;          // Transpose of the inverse of the model.
+    vec3 diffuseColor;          // Cycles through hues on the CPU.
+    // Values to control the rendered wave.
+    float amplitude;
+    float waveNumber;
+    float wavePeriod;
+    // Phases are wrapped on the CPU in double precision, so they stay
+    // small and precise however long the program runs.
+    float wavePhase;            // Offset that moves the wave.
+    float material_shininess;
+};
+
+layout(std140) uniform LightsBlock {
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+};
+
+// ============== OUT ==============
+// Export our normal data, and read it into our frag shader.
+// WORLD_LIGHTING is defined by SceneNode::init() for the world space
+// lighting mode, which only passes the world position and normal and
+// leaves the lights to the fragment shader.
+out VS_OUT {
+    vec3 Normal;
+#ifdef WORLD_LIGHTING
+    vec3 FragPos;
+#else
+    vec3 tanFragPos;
+    vec3 tanViewPos;
+    vec3 tanDirLightPos;
+    vec3 tanPointLightsPos[NR_POINT_LIGHTS];
+#endif
+} vs_out;
+
+// The values for Phase and Vertical Offset were ignored
+// in the calculations of sine and cosine, since the change
+// in phase did not heavily affect the result to great extents,
+// and vertical offset would only shift the figure up as a whole.
+// sineWave = Asin(k(xpos) - w(time) + p) + D
+// w(time) is computed on the CPU (SceneNode::waveVelocity()) and
+// arrives as wavePhase.
+// where:
+// A = amplitude
+// k = wavenumber = angular freq. / linear speed
+   // Higher wavenumber values bring the peaks closer together, meaning there are
+   // more waves in a unit of length.
+// w = angular freq. (rate of change radians per second) = 2.0 * PI / lambda
+   // Smaller w values slow down the movement of the wave.
+// lambda = linear speed / frequency
+   // A greater lambda results in a slower sine.
+// p = phase (in radians)
+// D = a non-zero center amplitude
+float calculateSine(float coord1, float coord2) {
+#if PLANE_MODE == 1
+    return amplitude * sin((waveNumber / 50 * coord1) - wavePhase);
+#else
+    return amplitude * sin((waveNumber / 100 * coord1) * ((waveNumber / 100) * coord2) - wavePhase);
+#endif
+}
+
+// Partial derivatives of calculateSine() along X and Z:
+// (1) d/dx A sin(kx - w) = A k cos(kx - w), and nothing along Z.
+// (2) d/dx A sin(k^2 xz - w) = A k^2 z cos(k^2 xz - w), and likewise
+//     along Z with x in place of z.
+vec2 calculateSlope(float coord1, float coord2) {
+#if PLANE_MODE == 1
+    float k = waveNumber / 50;
+    return vec2(amplitude * k * cos(k * coord1 - wavePhase), 0.0f);
+#else
+    float k = waveNumber / 100;
+    float c = amplitude * k * k * cos((k * coord1) * (k * coord2) - wavePhase);
+    return vec2(c * coord2, c * coord1);
+#endif
+}
+
+// Applies the wave to a position on the plane, and writes the
+// outputs of the stage and gl_Position.
+void emitWaveVertex(vec3 basePos) {
+    // Create variables
+    vec3 newPos = vec3(0.0f);   // Container for sine wave calculation results.
+    vec2 slope = vec2(0.0f);    // Slope of the wave along X and Z.
+
+    // Plane modes:
+    // (0) Render a plane.
+    // (1) Apply a sine wave on the Y axis only using the X coordinate.
+    // (2) Apply a sine wave on the Y axis by multiplying both the X and
+    //     Z coordinates.
+#if PLANE_MODE != 0
+    float newYpos = calculateSine(basePos.x, basePos.z);
+
+    newPos = vec3(basePos.x, newYpos, basePos.z);
+    slope  = calculateSlope(basePos.x, basePos.z);
+#else
+    newPos = vec3(basePos.x, 0.0f, basePos.z);
+#endif
+
+    // The surface runs along (1, dy/dx, 0) on X and along (0, dy/dz, 1)
+    // on Z, so the normal is perpendicular to both: (-dy/dx, 1, -dy/dz).
+    // Tangents move with the model matrix, and normals with the normal
+    // matrix.
+    vec3 N = normalize(normalMatrix * vec3(-slope.x, 1.0f, -slope.y));
+    vec3 FragPos = vec3(model * vec4(newPos, 1.0f));
+
+#ifdef WORLD_LIGHTING
+    // Pass the world position and normal as is.
+    vs_out.FragPos = FragPos;
+    vs_out.Normal = N;
+#else
+    // Compute TBN matrix.
+    vec3 T = normalize(mat3(model) * vec3(1.0f, slope.x, 0.0f));
+    // Keep the tangent perpendicular to the normal if the model is
+    // scaled unevenly, and complete the frame with the bitangent.
+    T = normalize(T - dot(T, N) * N);
+    vec3 B = cross(N, T);
+    // Rows of the world to tangent space rotation.
+    mat3 TBN = transpose(mat3(T, B, N));
+
+    // Compute the tangent light direction to increase light precision in the
+    // fragment shader.
+    vs_out.tanDirLightPos = TBN * lightDirection;
+
+    // Compute the position of each point light in tangent space for use in the
+    // fragment shader.
+    for (int i = 0; i < NR_POINT_LIGHTS; i++)
+        vs_out.tanPointLightsPos[i] = TBN * pointLights[i].position;
+    
+    // Compute and pass the tangent view position.
+    vs_out.tanViewPos = TBN * viewPos;
+
+    // Compute and pass the tangent fragment position.
+    vs_out.tanFragPos = TBN * FragPos;
+
+    // The normal is the Z axis of tangent space.
+    vs_out.Normal = vec3(0.0f, 0.0f, 1.0f);
+#endif
+
+    // Apply the Projection, View, and Model matrices to the vertex position.
+    gl_Position = modelViewProjection * vec4(newPos, 1.0f);
+}
+// ==================================================================
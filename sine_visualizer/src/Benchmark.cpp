@@ -0,0 +1,234 @@
+#if defined(LINUX) || defined(MINGW)
+    #include <SDL2/SDL.h>
+#else // This works for Mac
+    #include <SDL.h>
+#endif
+
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include "glm/glm.hpp"
+
+#include "Util.h"
+
+Benchmark::Benchmark() : m_gridX(0), m_gridZ(0), m_trianglesPerFrame(0), m_frameStart(0), m_frame(0) {
+    std::cout << "(Benchmark.cpp) Constructor Called\n";
+}
+
+Benchmark::~Benchmark() {
+    if (!m_queries.empty())
+        glDeleteQueries(m_queries.size(), m_queries.data());
+}
+
+void Benchmark::BeginRun(int gridX, int gridZ, unsigned long long trianglesPerFrame, int maxFrames) {
+    m_gridX = gridX;
+    m_gridZ = gridZ;
+    m_trianglesPerFrame = trianglesPerFrame;
+    m_frame = 0;
+    m_cpuTimes.clear();
+    m_cpuTimes.reserve(maxFrames);
+
+    // Reuse the query objects between runs when possible.
+    if ((int)m_queries.size() < maxFrames) {
+        if (!m_queries.empty())
+            glDeleteQueries(m_queries.size(), m_queries.data());
+        m_queries.resize(maxFrames);
+        glGenQueries(maxFrames, m_queries.data());
+    }
+}
+
+void Benchmark::BeginFrame() {
+    m_frameStart = SDL_GetPerformanceCounter();
+    if (m_frame < (int)m_queries.size())
+        glBeginQuery(GL_TIME_ELAPSED, m_queries[m_frame]);
+}
+
+void Benchmark::EndFrame() {
+    if (m_frame < (int)m_queries.size())
+        glEndQuery(GL_TIME_ELAPSED);
+    unsigned long long frameEnd = SDL_GetPerformanceCounter();
+    // * 1000 converts seconds into milliseconds
+    m_cpuTimes.push_back((double)(frameEnd - m_frameStart) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    m_frame++;
+}
+
+BenchmarkResult Benchmark::EndRun() {
+    // Every query is available once the GPU is idle.
+    glFinish();
+
+    std::vector<double> gpuTimes;
+    gpuTimes.reserve(m_frame);
+    for (int i = 0; i < m_frame && i < (int)m_queries.size(); i++) {
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(m_queries[i], GL_QUERY_RESULT, &nanoseconds);
+        gpuTimes.push_back((double)nanoseconds / 1.0e6);
+    }
+
+    BenchmarkResult result;
+    result.gridX = m_gridX;
+    result.gridZ = m_gridZ;
+    result.frames = m_frame;
+    result.trianglesPerFrame = m_trianglesPerFrame;
+    result.cpu = Summarize(m_cpuTimes);
+    result.gpu = Summarize(gpuTimes);
+    if (result.cpu.mean > 0.0)
+        result.trianglesPerSecond = (double)m_trianglesPerFrame * 1000.0 / result.cpu.mean;
+    return result;
+}
+
+// Orbits the plane at a fixed height while slowly moving in and out,
+// always looking at the center of the plane.
+void Benchmark::CameraPath(int frame, int frames, float extent, glm::vec3& eye, glm::vec3& viewDir) {
+    float t = (frames > 1) ? (float)frame / (float)(frames - 1) : 0.0f;
+    float angle = 2.0f * PI * t;
+    float radius = extent * (0.75f + 0.25f * std::cos(4.0f * PI * t));
+    float height = extent * 0.5f;
+
+    eye = glm::vec3(radius * std::cos(angle), height, radius * std::sin(angle));
+    viewDir = glm::normalize(glm::vec3(0.0f) - eye);
+}
+
+// Uses the nearest-rank method for percentiles.
+TimingStats Benchmark::Summarize(std::vector<double> samples) {
+    TimingStats stats;
+    if (samples.empty())
+        return stats;
+
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples)
+        sum += sample;
+
+    auto percentile = [&samples](double p) {
+        size_t rank = (size_t)std::ceil(p / 100.0 * samples.size());
+        if (rank < 1) rank = 1;
+        return samples[rank - 1];
+    };
+
+    stats.mean = sum / samples.size();
+    stats.p50 = percentile(50.0);
+    stats.p95 = percentile(95.0);
+    stats.p99 = percentile(99.0);
+    stats.min = samples.front();
+    stats.max = samples.back();
+    return stats;
+}
+
+static void writeStatsJSON(std::ofstream& file, const char* name, const TimingStats& stats) {
+    file << "      \"" << name << "\": { "
+         << "\"mean\": " << stats.mean << ", "
+         << "\"p50\": " << stats.p50 << ", "
+         << "\"p95\": " << stats.p95 << ", "
+         << "\"p99\": " << stats.p99 << ", "
+         << "\"min\": " << stats.min << ", "
+         << "\"max\": " << stats.max << " }";
+}
+
+// Escapes the characters JSON does not allow inside strings.
+static std::string escapeJSON(const std::string& str) {
+    std::string result;
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            result += '\\';
+        result += c;
+    }
+    return result;
+}
+
+bool Benchmark::WriteJSON(const std::string& filepath, const std::vector<BenchmarkResult>& results,
+                          int width, int height, const std::string& vendor, const std::string& renderer) {
+    std::ofstream file(filepath.c_str());
+    if (!file.is_open()) {
+        std::cout << "ERROR - Unable to write benchmark file: " << filepath << "\n";
+        return false;
+    }
+
+    file << "{\n"
+         << "  \"vendor\": \"" << escapeJSON(vendor) << "\",\n"
+         << "  \"renderer\": \"" << escapeJSON(renderer) << "\",\n"
+         << "  \"width\": " << width << ",\n"
+         << "  \"height\": " << height << ",\n"
+         << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& r = results[i];
+        file << "    {\n"
+             << "      \"grid\": \"" << escapeJSON(r.grid) << "\",\n"
+             << "      \"lighting\": \"" << escapeJSON(r.lighting) << "\",\n"
+             << "      \"grid_x\": " << r.gridX << ",\n"
+             << "      \"grid_z\": " << r.gridZ << ",\n"
+             << "      \"buffer_bytes\": " << r.bufferBytes << ",\n"
+             << "      \"frames\": " << r.frames << ",\n"
+             << "      \"triangles_per_frame\": " << r.trianglesPerFrame << ",\n"
+             << "      \"triangles_per_second\": " << r.trianglesPerSecond << ",\n";
+        writeStatsJSON(file, "cpu_ms", r.cpu);
+        file << ",\n";
+        writeStatsJSON(file, "gpu_ms", r.gpu);
+        file << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    std::cout << "Saved benchmark results to " << filepath << "\n";
+    return true;
+}
+
+bool Benchmark::WriteCSV(const std::string& filepath, const std::vector<BenchmarkResult>& results) {
+    std::ofstream file(filepath.c_str());
+    if (!file.is_open()) {
+        std::cout << "ERROR - Unable to write benchmark file: " << filepath << "\n";
+        return false;
+    }
+
+    file << "grid,lighting,grid_x,grid_z,buffer_bytes,frames,triangles_per_frame,triangles_per_second,"
+         << "cpu_mean_ms,cpu_p50_ms,cpu_p95_ms,cpu_p99_ms,"
+         << "gpu_mean_ms,gpu_p50_ms,gpu_p95_ms,gpu_p99_ms\n";
+    for (const BenchmarkResult& r : results) {
+        file << r.grid << "," << r.lighting << "," << r.gridX << "," << r.gridZ << "," << r.bufferBytes << "," << r.frames << ","
+             << r.trianglesPerFrame << "," << r.trianglesPerSecond << ","
+             << r.cpu.mean << "," << r.cpu.p50 << "," << r.cpu.p95 << "," << r.cpu.p99 << ","
+             << r.gpu.mean << "," << r.gpu.p50 << "," << r.gpu.p95 << "," << r.gpu.p99 << "\n";
+    }
+    std::cout << "Saved benchmark results to " << filepath << "\n";
+    return true;
+}
+
+void Benchmark::Print(const BenchmarkResult& r) {
+    std::cout << "[Benchmark] " << r.grid << " " << r.lighting << " " << r.gridX << "x" << r.gridZ
+              << "  frames: " << r.frames
+              << "  buffers: " << r.bufferBytes / 1024.0 << " KiB"
+              << "  cpu ms mean/p50/p95/p99: " << r.cpu.mean << "/" << r.cpu.p50 << "/" << r.cpu.p95 << "/" << r.cpu.p99
+              << "  gpu ms mean/p50/p95/p99: " << r.gpu.mean << "/" << r.gpu.p50 << "/" << r.gpu.p95 << "/" << r.gpu.p99
+              << "  Mtris/s: " << r.trianglesPerSecond / 1.0e6 << "\n";
+}
+
+void Benchmark::PrintComparison(const std::vector<BenchmarkResult>& results) {
+    if (results.empty())
+        return;
+    const BenchmarkResult& baseline = results.front();
+    std::cout << "\n[Benchmark] Compared to " << baseline.grid << " " << baseline.lighting << " at the same size\n"
+              << "    " << std::left << std::setw(14) << "Grid" << std::setw(10) << "Lighting" << std::setw(12) << "Size"
+              << std::right << std::setw(12) << "CPU ms" << std::setw(12) << "GPU ms"
+              << std::setw(14) << "Buffer KiB" << std::setw(10) << "CPU x" << std::setw(10) << "GPU x" << "\n";
+    for (const BenchmarkResult& r : results) {
+        const BenchmarkResult* base = nullptr;
+        for (const BenchmarkResult& candidate : results) {
+            if (candidate.grid == baseline.grid && candidate.lighting == baseline.lighting && candidate.gridX == r.gridX && candidate.gridZ == r.gridZ) {
+                base = &candidate;
+                break;
+            }
+        }
+        std::string size = std::to_string(r.gridX) + "x" + std::to_string(r.gridZ);
+        std::cout << "    " << std::left << std::setw(14) << r.grid << std::setw(10) << r.lighting << std::setw(12) << size
+                  << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << r.cpu.mean << std::setw(12) << r.gpu.mean
+                  << std::setprecision(1) << std::setw(14) << r.bufferBytes / 1024.0
+                  << std::setprecision(2);
+        // Speedups over the baseline, above 1 when faster
+        if (base != nullptr && r.cpu.mean > 0.0 && r.gpu.mean > 0.0)
+            std::cout << std::setw(10) << base->cpu.mean / r.cpu.mean << std::setw(10) << base->gpu.mean / r.gpu.mean;
+        std::cout << "\n" << std::defaultfloat;
+    }
+}
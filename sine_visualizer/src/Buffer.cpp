@@ -35,6 +35,10 @@ void Buffer::Unbind(){
 
 
 void Buffer::CreateBufferLayout(unsigned int stride, unsigned int vcount, unsigned int icount, float* vdata, unsigned int* idata ){
+    CreateBufferLayout(stride, vcount, icount, vdata, (const void*)idata, sizeof(unsigned int));
+}
+
+void Buffer::CreateBufferLayout(unsigned int stride, unsigned int vcount, unsigned int icount, float* vdata, const void* idata, unsigned int indexSize ){
     std::cout << "Created new buffer layout.\n";
 
     m_stride = stride;
@@ -66,7 +70,7 @@ void Buffer::CreateBufferLayout(unsigned int stride, unsigned int vcount, unsign
     // Vertex Buffer Object (VBO) for the index buffer.
     glGenBuffers(1, &m_indexBufferObject);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBufferObject);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount * sizeof(unsigned int), idata, GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, icount * indexSize, idata, GL_STATIC_DRAW);
 }
 
 void Buffer::CreateBufferTextureLayout(unsigned int stride,unsigned int vcount,unsigned int icount, float* vdata, unsigned int* idata ) {
@@ -157,3 +161,12 @@ void Buffer::CreateBufferNormalMapLayout(unsigned int stride,unsigned int vcount
 
 
 
+
+// A core profile cannot draw without a vertex array bound, even when
+// no attributes are read.
+void Buffer::CreateEmptyLayout(){
+    std::cout << "Created new empty buffer layout.\n";
+    m_stride = 0;
+    glGenVertexArrays(1, &m_VAOid);
+    glBindVertexArray(m_VAOid);
+}
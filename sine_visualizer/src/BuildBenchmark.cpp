@@ -0,0 +1,225 @@
+#if defined(LINUX) || defined(MINGW)
+    #include <SDL2/SDL.h>
+#else // This works for Mac
+    #include <SDL.h>
+#endif
+
+#include "BuildBenchmark.h"
+#include "Geometry.h"
+#include "Terrain.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+
+#if defined(LINUX)
+    #include <sys/wait.h>
+    #include <unistd.h>
+#endif
+
+const char* BuildBenchmark::MethodName(Method method) {
+    switch (method) {
+        case Method::Builder:
+            return "builder";
+        default:
+            return "legacy";
+    }
+}
+
+// FNV-1a over a block of bytes, continuing from 'hash'.
+static unsigned long long hashBytes(const void* data, size_t bytes, unsigned long long hash) {
+    const unsigned char* byte = (const unsigned char*)data;
+    for (size_t i = 0; i < bytes; i++) {
+        hash ^= byte[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Both methods build the same plane Terrain::init() builds when no
+// texture is given.
+void BuildBenchmark::Build(Method method, int size, int threads, BuildResult& result) {
+    // The workers are started here rather than by Run(), since a forked
+    // child only inherits the thread that called fork().
+    ThreadPool::Get().SetThreadCount(threads);
+
+    unsigned long long start = SDL_GetPerformanceCounter();
+
+    Geometry geometry;
+    if (method == Method::Legacy) {
+        for (int z = 0; z < size; ++z) {
+            for (int x = 0; x < size; ++x) {
+                geometry.addVertex(x - size / 2.0f, 0.0f, z - size / 2.0f);
+            }
+        }
+        geometry.makeGridStrips(size, size);
+        geometry.gen();
+    } else {
+        Terrain::buildFlatPlane(geometry, size, size);
+    }
+
+    unsigned long long end = SDL_GetPerformanceCounter();
+    result.method = MethodName(method);
+    result.size = size;
+    result.threads = threads;
+    result.milliseconds = (double)(end - start) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+    size_t indexBytes = (size_t)geometry.getIndicesSize() * geometry.getIndexTypeSize();
+    result.dataMegabytes = ((double)geometry.getSizeInBytes() + (double)indexBytes) / (1024.0 * 1024.0);
+    result.checksum = hashBytes(geometry.getData(), geometry.getSizeInBytes(), 14695981039346656037ULL);
+    result.checksum = hashBytes(geometry.getIndexBytes(), indexBytes, result.checksum);
+}
+
+#if defined(LINUX)
+// Reads a field such as "VmHWM" from /proc/self/status in kilobytes.
+static long readStatusKilobytes(const char* field) {
+    FILE* file = std::fopen("/proc/self/status", "r");
+    if (file == nullptr)
+        return 0;
+    char line[256];
+    long value = 0;
+    size_t length = std::strlen(field);
+    while (std::fgets(line, sizeof(line), file) != nullptr) {
+        if (std::strncmp(line, field, length) == 0 && line[length] == ':') {
+            value = std::atol(line + length + 1);
+            break;
+        }
+    }
+    std::fclose(file);
+    return value;
+}
+#endif
+
+// What a child process sends back through the pipe
+struct MeasureMessage {
+    double milliseconds;
+    double peakMegabytes;
+    double dataMegabytes;
+    unsigned long long checksum;
+};
+
+bool BuildBenchmark::Measure(Method method, int size, int threads, BuildResult& result) {
+#if defined(LINUX)
+    int fds[2];
+    if (pipe(fds) != 0)
+        return false;
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        // The child starts with the parent's pages, so only the growth
+        // of the peak is due to the build.
+        close(fds[0]);
+        long before = readStatusKilobytes("VmRSS");
+        BuildResult childResult;
+        Build(method, size, threads, childResult);
+        long peak = readStatusKilobytes("VmHWM");
+        MeasureMessage message = { childResult.milliseconds, (double)(peak - before) / 1024.0,
+                                   childResult.dataMegabytes, childResult.checksum };
+        ssize_t written = write(fds[1], &message, sizeof(message));
+        close(fds[1]);
+        _exit(written == (ssize_t)sizeof(message) ? 0 : 1);
+    }
+    close(fds[1]);
+    MeasureMessage message = { 0.0, 0.0, 0.0, 0 };
+    ssize_t got = read(fds[0], &message, sizeof(message));
+    close(fds[0]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (got != (ssize_t)sizeof(message) || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return false;
+    result.method = MethodName(method);
+    result.size = size;
+    result.threads = threads;
+    result.milliseconds = message.milliseconds;
+    result.peakMegabytes = message.peakMegabytes;
+    result.dataMegabytes = message.dataMegabytes;
+    result.checksum = message.checksum;
+    return true;
+#else
+    // Without fork() only the time can be measured.
+    Build(method, size, threads, result);
+    return true;
+#endif
+}
+
+void BuildBenchmark::Print(const BuildResult& result, std::ostream& out) {
+    out << "[BuildBenchmark] " << std::left
+        << std::setw(12) << (std::to_string(result.size) + "x" + std::to_string(result.size))
+        << std::setw(10) << result.method
+        << std::right << std::setw(8) << result.threads
+        << std::fixed << std::setprecision(1)
+        << std::setw(12) << result.milliseconds << std::setw(14) << result.peakMegabytes
+        << std::setw(12) << result.dataMegabytes;
+}
+
+bool BuildBenchmark::Run(const std::vector<int>& sizes, int maxThreads, std::ostream& out) {
+    if (maxThreads <= 0)
+        maxThreads = (int)std::max(1u, std::thread::hardware_concurrency());
+    // Powers of two up to the maximum, and the maximum itself
+    std::vector<int> threadCounts;
+    for (int threads = 2; threads < maxThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    if (maxThreads > 1)
+        threadCounts.push_back(maxThreads);
+
+    bool success = true;
+    out << "[BuildBenchmark] " << std::left
+        << std::setw(12) << "size" << std::setw(10) << "method"
+        << std::right << std::setw(8) << "threads" << std::setw(12) << "build ms"
+        << std::setw(14) << "peak RSS MB" << std::setw(12) << "data MB" << "\n";
+    for (int size : sizes) {
+        BuildResult legacy;
+        if (!Measure(Method::Legacy, size, 1, legacy)) {
+            out << "[BuildBenchmark] " << size << "x" << size << " " << MethodName(Method::Legacy)
+                << " failed (out of memory?)\n";
+            success = false;
+        } else {
+            Print(legacy, out);
+            out << "\n" << std::defaultfloat;
+        }
+
+        BuildResult serial;
+        if (!Measure(Method::Builder, size, 1, serial)) {
+            out << "[BuildBenchmark] " << size << "x" << size << " " << MethodName(Method::Builder)
+                << " failed (out of memory?)\n";
+            success = false;
+            continue;
+        }
+        Print(serial, out);
+        if (serial.milliseconds > 0.0 && legacy.milliseconds > 0.0) {
+            out << "   (" << legacy.milliseconds / serial.milliseconds << "x faster";
+            if (serial.peakMegabytes > 0.0 && legacy.peakMegabytes > 0.0)
+                out << ", " << legacy.peakMegabytes / serial.peakMegabytes << "x less memory";
+            out << ")";
+        }
+        out << "\n" << std::defaultfloat;
+
+        // Scaling of the builder, which must build the same bytes on
+        // any number of threads.
+        for (int threads : threadCounts) {
+            BuildResult result;
+            if (!Measure(Method::Builder, size, threads, result)) {
+                out << "[BuildBenchmark] " << size << "x" << size << " " << MethodName(Method::Builder)
+                    << " on " << threads << " threads failed\n";
+                success = false;
+                continue;
+            }
+            Print(result, out);
+            if (result.milliseconds > 0.0)
+                out << "   (" << serial.milliseconds / result.milliseconds << "x vs 1 thread";
+            if (result.checksum == serial.checksum) {
+                out << ", identical)";
+            } else {
+                out << ", DIFFERENT data than 1 thread)";
+                success = false;
+            }
+            out << "\n" << std::defaultfloat;
+        }
+    }
+    return success;
+}
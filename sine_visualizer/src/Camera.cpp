@@ -6,10 +6,12 @@ Camera::Camera(){
     return;
 }
 
-void Camera::setView(glm::vec3 eyePos, glm::vec3 viewDir, glm::vec3 upVec) {
+void Camera::setView(glm::vec3 eyePos, glm::vec3 viewDir, glm::vec3 upVec, bool verbose) {
     eyePosition = eyePos;
     viewDirection = viewDir;
     upVector = upVec;
+    if (!verbose)
+        return;
     std::cout << "New Eye Position:\n\tX: " << eyePos.x << "\tY: " << eyePos.y << "\tZ: " << eyePos.z << "\n";
     std::cout << "New View Direction:\n\tX: " << viewDir.x << "\tY: " << viewDir.y << "\tZ: " << viewDir.z << "\n";
     std::cout << "New Up Vector:\n\tX: " << upVec.x << "\tY: " << upVec.y << "\tZ: " << upVec.z << "\n";
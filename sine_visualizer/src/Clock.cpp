@@ -0,0 +1,147 @@
+#include "Clock.h"
+
+#include <cmath>
+#include <iomanip>
+
+SimulationClock::SimulationClock(double rate) : m_steps(0) {
+    if (rate <= 0.0)
+        rate = 120.0;
+    m_stepsPerKilosecond = (unsigned long long)std::llround(rate * 1000.0);
+    if (m_stepsPerKilosecond == 0)
+        m_stepsPerKilosecond = 1;
+}
+
+unsigned long long SimulationClock::GetTicks() const {
+    // Whole kiloseconds first, so the product never overflows.
+    const unsigned long long TICKS_PER_KILOSECOND = TICKS_PER_SECOND * 1000ULL;
+    unsigned long long kiloseconds = m_steps / m_stepsPerKilosecond;
+    unsigned long long remainder = m_steps % m_stepsPerKilosecond;
+    return kiloseconds * TICKS_PER_KILOSECOND + remainder * TICKS_PER_KILOSECOND / m_stepsPerKilosecond;
+}
+
+double SimulationClock::GetSeconds() const {
+    // Split into whole and partial kiloseconds so the result stays
+    // as precise as a double can for any uptime.
+    unsigned long long kiloseconds = m_steps / m_stepsPerKilosecond;
+    unsigned long long remainder = m_steps % m_stepsPerKilosecond;
+    return (double)kiloseconds * 1000.0 + (double)remainder * 1000.0 / (double)m_stepsPerKilosecond;
+}
+
+double SimulationClock::GetStepSeconds() const {
+    return 1000.0 / (double)m_stepsPerKilosecond;
+}
+
+Phase::Phase(double period) : m_value(0.0), m_period(period) {
+}
+
+void Phase::Advance(double velocity, double seconds) {
+    m_value = Wrap(m_value + velocity * seconds, m_period);
+}
+
+float Phase::Sample(double velocity, double seconds) const {
+    return (float)Wrap(m_value + velocity * seconds, m_period);
+}
+
+double Phase::Wrap(double value, double period) {
+    double wrapped = std::fmod(value, period);
+    if (wrapped < 0.0)
+        wrapped += period;
+    // fmod of a tiny negative value can round up to exactly period.
+    if (wrapped >= period)
+        wrapped = 0.0;
+    return wrapped;
+}
+
+WaveAnimation::WaveAnimation() : hue(Phase::FULL_TURN / 2.0) {
+}
+
+// The wave phase is integrated rather than recomputed from the total
+// time, so changing the wave period changes the speed without making
+// the wave jump.
+void WaveAnimation::Advance(double waveVelocity, double seconds) {
+    wave.Advance(waveVelocity, seconds);
+    light.Advance(LIGHT_VELOCITY, seconds);
+    hue.Advance(HUE_VELOCITY, seconds);
+    saturation.Advance(SATURATION_VELOCITY, seconds);
+}
+
+double WaveAnimation::WaveVelocity(double wavePeriod) {
+    // The angular frequency (in degrees) ensures that the number of
+    // oscillations does not keep increasing with every iteration, as
+    // time increases.
+    const double ANGULAR_FREQUENCY = 0.05;
+    return (ANGULAR_FREQUENCY * Phase::FULL_TURN / 360.0) * wavePeriod * TIME_SCALE;
+}
+
+// The reference phase is computed from the integer step count in
+// long double, independently of the stepped phase. Every step also
+// checks that the value sent to the shaders moved by the same amount,
+// which is what keeps the waves smooth. For comparison, the same time
+// is accumulated the way it used to be, in float milliseconds.
+bool SimulationClock::Soak(double days, double rate, std::ostream& out) {
+    const double TWO_PI = Phase::FULL_TURN;
+    // Radians per second of a wave with the default wave period of 50
+    const double waveVelocity = WaveAnimation::WaveVelocity(50.0);
+    // A float holds an angle near 2 pi to within about 5e-7.
+    const double tolerance = 1.0e-5;
+
+    SimulationClock clock(rate);
+    // Stepped the same way SceneNode::Advance() steps its animation
+    WaveAnimation animation;
+    float legacyMilliseconds = 0.0f;
+    const float legacyStep = (float)(clock.GetStepSeconds() * 1000.0);
+
+    const unsigned long long totalSteps = (unsigned long long)(days * 86400.0 * rate);
+    const double step = clock.GetStepSeconds();
+    const double expectedStep = waveVelocity * step;
+    const long double exactStep = (long double)waveVelocity * 1000.0L / (long double)clock.m_stepsPerKilosecond;
+    // Compare against the reference once per simulated minute.
+    const unsigned long long checkInterval = (unsigned long long)(rate * 60.0);
+
+    double maxError = 0.0;
+    double maxStepError = 0.0;
+    float previous = 0.0f;
+    // Step the legacy float clock stopped advancing at (0 = never)
+    unsigned long long legacyStalledAt = 0;
+    double legacyMaxJitter = 0.0;
+
+    out << "[ClockSoak] Simulating " << days << " day(s) at " << rate << " steps per second ("
+        << totalSteps << " steps).\n";
+    for (unsigned long long i = 1; i <= totalSteps; i++) {
+        clock.Step();
+        animation.Advance(waveVelocity, step);
+
+        // The value the shaders receive
+        float sent = (float)animation.wave.Get();
+        double moved = Phase::Wrap((double)sent - (double)previous, TWO_PI);
+        maxStepError = std::fmax(maxStepError, std::fabs(moved - expectedStep));
+        previous = sent;
+
+        float legacyPrevious = legacyMilliseconds;
+        legacyMilliseconds += legacyStep;
+        legacyMaxJitter = std::fmax(legacyMaxJitter, std::fabs((double)(legacyMilliseconds - legacyPrevious) - legacyStep));
+        if (legacyStalledAt == 0 && legacyMilliseconds == legacyPrevious)
+            legacyStalledAt = i;
+
+        if (i % checkInterval == 0 || i == totalSteps) {
+            long double reference = std::fmod(exactStep * (long double)i, (long double)TWO_PI);
+            double error = std::fabs((double)sent - (double)reference);
+            // Both sides of the wrap are the same angle.
+            maxError = std::fmax(maxError, std::fmin(error, TWO_PI - error));
+        }
+    }
+
+    bool passed = maxError < tolerance && maxStepError < tolerance;
+    out << std::setprecision(9)
+        << "[ClockSoak] Elapsed: " << clock.GetSeconds() << " s (" << clock.GetTicks() << " ns)\n"
+        << "[ClockSoak] Max phase error: " << maxError << " rad\n"
+        << "[ClockSoak] Max step error:  " << maxStepError << " rad (step of " << expectedStep << " rad)\n"
+        << "[ClockSoak] Light phase: " << animation.light.Get() << " rad\n";
+    out << "[ClockSoak] A float millisecond clock would have steps off by up to "
+        << legacyMaxJitter << " ms (step of " << legacyStep << " ms).\n";
+    if (legacyStalledAt != 0)
+        out << "[ClockSoak] A float millisecond clock would have stopped after "
+            << (double)legacyStalledAt / rate / 3600.0 << " hours.\n";
+    out << "[ClockSoak] " << (passed ? "PASSED" : "FAILED") << "\n" << std::defaultfloat;
+    return passed;
+}
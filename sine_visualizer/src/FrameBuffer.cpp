@@ -6,32 +6,51 @@
 
 
 #include "FrameBuffer.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
 #include <glad/glad.h>
 
 
-Framebuffer::Framebuffer(){
+const int Framebuffer::EFFECT_COUNT;
+const char* const Framebuffer::EFFECT_NAMES[EFFECT_COUNT] = {
+    "standard", "grayscale", "blur", "invertColors", "sharpen", "edgeDetection"
+};
+
+bool Framebuffer::IsEffect(const std::string& name){
+    for (const char* effect : EFFECT_NAMES)
+        if (name == effect)
+            return true;
+    return false;
+}
+
+std::string Framebuffer::EffectShader(const std::string& name){
+    return "./shaders/fboFrag_" + name + ".glsl";
+}
+
+// Whether an effect draws its input unchanged
+static bool isIdentity(const std::string& fboFragShader){
+    const std::string identity = "fboFrag_standard.glsl";
+    return fboFragShader.size() >= identity.size() &&
+           fboFragShader.compare(fboFragShader.size() - identity.size(), identity.size(), identity) == 0;
+}
+
+Framebuffer::Framebuffer() : pingPongFBO_id(0), pingPongBuffer_id(0), m_width(0), m_height(0){
     std::cout << "(FrameBuffer.cpp) Constructor Called\n";
     // (1) ======= Setup shader
-    fboShader = new Shader;
-    // Setup shaders for the Framebuffer Object
-    std::string fboVertexShader = fboShader->LoadShader("./shaders/fboVert.glsl");
-    std::string fboFragmentShader = fboShader->LoadShader("./shaders/fboFrag_standard.glsl");
-    // Actually create our shader
-    fboShader->CreateShader(fboVertexShader, fboFragmentShader);       
+    // Every effect is compiled now, so switching effects later
+    // never waits on the compiler.
+    loadEffects();
+    setEffect(EffectShader(EFFECT_NAMES[0]));
     // (2) ======= Setup quad to draw to
     // Setup the screen quad
     setupScreenQuad(0,0,0,0);
 }
 
 // Alternate constructor for setting the FBO fragment shader based on a string input
-Framebuffer::Framebuffer(std::string fboFragShader){
+Framebuffer::Framebuffer(std::string fboFragShader) : pingPongFBO_id(0), pingPongBuffer_id(0), m_width(0), m_height(0){
     // (1) ======= Setup shader
-    fboShader = new Shader;
-    // Setup shaders for the Framebuffer Object
-    std::string fboVertexShader = fboShader->LoadShader("./shaders/fboVert.glsl");
-    std::string fboFragmentShader = fboShader->LoadShader(fboFragShader);
-    // Actually create our shader
-    fboShader->CreateShader(fboVertexShader,fboFragmentShader);       
+    loadEffects();
+    setEffect(fboFragShader);
     // (2) ======= Setup quad to draw to
     // Setup the screen quad
     setupScreenQuad(0,0,0,0);
@@ -40,7 +59,12 @@ Framebuffer::Framebuffer(std::string fboFragShader){
 // Destructor
 Framebuffer::~Framebuffer(){
     glDeleteFramebuffers(1,&fbo_id); 
-    delete fboShader;
+    glDeleteTextures(1,&colorBuffer_id);
+    glDeleteRenderbuffers(1,&rbo_id);
+    if (pingPongFBO_id != 0) {
+        glDeleteFramebuffers(1,&pingPongFBO_id);
+        glDeleteTextures(1,&pingPongBuffer_id);
+    }
     glDeleteVertexArrays(1,&quadVAO);
     glDeleteBuffers(1,&quadVBO);
 }
@@ -52,6 +76,8 @@ Framebuffer::~Framebuffer(){
 // TODO: What happens if the window resizes?
 //       Answer: Need to regenerate our buffer
 void Framebuffer::Create(int width, int height){
+    m_width = width;
+    m_height = height;
 
     // Generate a framebuffer
     glGenFramebuffers(1, &fbo_id);
@@ -77,37 +103,116 @@ void Framebuffer::Bind(){
     glBindFramebuffer(GL_FRAMEBUFFER, fbo_id);
 }
 
-// Update our framebuffer once per frame for any
-// changes that may have occurred.
-void Framebuffer::Update(){
-    // Select our framebuffer
-    fboShader->Bind();
-    // Set the uniforms in our current shader
-
-    // For our object, we apply the texture in the following way
-    // Note that we set the value to 0, because we have bound
-    // our texture to slot 0.
-    fboShader->setUniform1i("u_DiffuseMap",0);  
-}
-
 // Done with our framebuffer
 void Framebuffer::Unbind(){
     glBindFramebuffer(GL_FRAMEBUFFER,0);
 }
 
-// Draws the screen quad
-// This is the actual rendering of our FBO to the screen.
-// Typically this would be called after 'update'
-void Framebuffer::drawFBO(){
+// Draws every pass of the chain. Each pass reads the target the one
+// before it wrote, and the last one draws to the screen.
+void Framebuffer::drawPasses(bool wireframe){
+    PROFILE_SCOPE("Framebuffer::drawPasses");
+    if (m_activePasses.size() > 1 && pingPongFBO_id == 0)
+        createPingPong();
     glBindVertexArray(quadVAO);
-    glBindTexture(GL_TEXTURE_2D, colorBuffer_id);   // use the color attachment texture as the texture of the quad plane
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    unsigned int source = colorBuffer_id;
+    for (size_t i = 0; i < m_activePasses.size(); i++) {
+        unsigned int target = (source == colorBuffer_id) ? pingPongBuffer_id : colorBuffer_id;
+        if (i + 1 < m_activePasses.size()) {
+            // The quad covers every pixel of the target, so it is
+            // never cleared first.
+            glBindFramebuffer(GL_FRAMEBUFFER, (target == colorBuffer_id) ? fbo_id : pingPongFBO_id);
+            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        } else {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glPolygonMode(GL_FRONT_AND_BACK, (wireframe) ? GL_LINE : GL_FILL);
+            // Only the wireframe leaves pixels of the screen undrawn,
+            // so that is the only time it is cleared.
+            if (wireframe) {
+                glClearColor(1.0f,1.0f,1.0f,1.0f);
+                glClear(GL_COLOR_BUFFER_BIT);
+            }
+        }
+        m_activePasses[i]->Bind();
+        glBindTexture(GL_TEXTURE_2D, source);   // use the previous pass's color as the texture of the quad plane
+        glDrawArrays(GL_TRIANGLES, 0, 6);
+        source = target;
+    }
+    m_activePasses.back()->Unbind();
+}
+
+// Swaps the chain for one effect. The attachments stay as they are.
+void Framebuffer::setEffect(const std::string& fboFragShader){
+    m_passes.clear();
+    addPass(fboFragShader);
+}
+
+// Adds an effect to the end of the chain
+void Framebuffer::addPass(const std::string& fboFragShader){
+    m_passes.push_back(fboFragShader);
+    updateActivePasses();
 }
 
 // ============== Private Member Functions ==============
 // ============== Private Member Functions ==============
 // ============== Private Member Functions ==============
 
+// Compiles every effect into the registry. ShaderCache keeps the
+// programs, and loads them from their binaries when it can.
+void Framebuffer::loadEffects(){
+    for (const char* effect : EFFECT_NAMES)
+        getEffect(EffectShader(effect));
+}
+
+// Returns the program of an effect, compiling it the first time
+Shader* Framebuffer::getEffect(const std::string& fboFragShader){
+    auto found = m_effects.find(fboFragShader);
+    if (found != m_effects.end())
+        return found->second;
+    ShaderFiles files;
+    files.vertex = "./shaders/fboVert.glsl";
+    files.fragment = fboFragShader;
+    Shader* program = ShaderCache::Get().GetProgram(files, ShaderDefines());
+    // Every pass reads the texture bound to slot 0, which never
+    // changes, so the sampler is set once here.
+    program->Bind();
+    program->setUniform1i("u_DiffuseMap",0);
+    program->Unbind();
+    m_effects[fboFragShader] = program;
+    return program;
+}
+
+// Looks up the programs of the chain when it changes, so drawing
+// it does no string or map work. Identity passes are skipped. If
+// every pass is one, a single identity pass still draws the scene
+// to the screen.
+void Framebuffer::updateActivePasses(){
+    m_activePasses.clear();
+    for (const std::string& pass : m_passes) {
+        // Compiled now if it is not in the registry yet, rather than
+        // in the middle of a frame.
+        Shader* program = getEffect(pass);
+        if (!isIdentity(pass))
+            m_activePasses.push_back(program);
+    }
+    if (m_activePasses.empty())
+        m_activePasses.push_back(getEffect(EffectShader(EFFECT_NAMES[0])));
+}
+
+// Creates the second color target, the same as the scene's but
+// without depth, since the passes do not test depth.
+void Framebuffer::createPingPong(){
+    glGenFramebuffers(1, &pingPongFBO_id);
+    glBindFramebuffer(GL_FRAMEBUFFER, pingPongFBO_id);
+    glGenTextures(1, &pingPongBuffer_id);
+    glBindTexture(GL_TEXTURE_2D, pingPongBuffer_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_width, m_height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingPongBuffer_id, 0);
+    Unbind();
+}
+
 // Creates a quad that will be overlaid on top of the screen
 // TODO: add x1,x2, etc. to draw FBO over a range in the scene.
 void Framebuffer::setupScreenQuad(float x1,float x2, float y1, float y2){
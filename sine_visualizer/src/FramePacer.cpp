@@ -0,0 +1,140 @@
+#if defined(LINUX) || defined(MINGW)
+    #include <SDL2/SDL.h>
+#else // This works for Mac
+    #include <SDL.h>
+#endif
+
+#include "FramePacer.h"
+
+FramePacer::FramePacer() : m_mode(PacingMode::Unlimited), m_targetFPS(60.0), m_refreshRate(0.0), m_periodTicks(0), m_deadline(0),
+                           m_frameStart(0), m_firstFrameStart(0), m_deltaSeconds(0.0), m_frameCount(0), m_missedDeadlines(0) {
+    Configure(PacingMode::Unlimited, 60.0);
+}
+
+void FramePacer::Configure(PacingMode mode, double targetFPS, double refreshRate) {
+    m_mode = mode;
+    m_targetFPS = (targetFPS > 0.0) ? targetFPS : 60.0;
+    m_refreshRate = (refreshRate > 0.0) ? refreshRate : 0.0;
+    updatePeriod();
+    m_deadline = 0;
+}
+
+double FramePacer::expectedRate() const {
+    // A swap interval of 1 (or -1) presents once per refresh.
+    if ((m_mode == PacingMode::VSync || m_mode == PacingMode::AdaptiveVSync) && m_refreshRate > 0.0)
+        return m_refreshRate;
+    return m_targetFPS;
+}
+
+void FramePacer::updatePeriod() {
+    m_periodTicks = (unsigned long long)((double)SDL_GetPerformanceFrequency() / expectedRate());
+}
+
+int FramePacer::GetSwapInterval() const {
+    switch (m_mode) {
+        case PacingMode::VSync:
+            return 1;
+        case PacingMode::AdaptiveVSync:
+            return -1;
+        default:
+            return 0;
+    }
+}
+
+void FramePacer::FallBackToVSync() {
+    if (m_mode == PacingMode::AdaptiveVSync)
+        m_mode = PacingMode::VSync;
+}
+
+void FramePacer::BeginFrame() {
+    unsigned long long now = SDL_GetPerformanceCounter();
+    if (m_frameCount == 0) {
+        m_firstFrameStart = now;
+        m_deltaSeconds = 0.0;
+    } else {
+        unsigned long long elapsed = now - m_frameStart;
+        m_deltaSeconds = (double)elapsed / (double)SDL_GetPerformanceFrequency();
+        if (m_mode != PacingMode::Unlimited && elapsed > m_periodTicks * MISSED_DEADLINE_FACTOR)
+            m_missedDeadlines++;
+    }
+    m_frameStart = now;
+    m_frameCount++;
+}
+
+void FramePacer::Wait() {
+    if (m_mode != PacingMode::TargetFPS)
+        return;
+
+    unsigned long long now = SDL_GetPerformanceCounter();
+    // Deadlines follow on from each other so rounding does not drift.
+    // After a late frame they restart from now rather than trying to
+    // catch up with a burst of frames.
+    m_deadline = (m_deadline == 0) ? m_frameStart + m_periodTicks : m_deadline + m_periodTicks;
+    if (m_deadline <= now) {
+        m_deadline = now;
+        return;
+    }
+
+    const double frequency = (double)SDL_GetPerformanceFrequency();
+    double remaining = (double)(m_deadline - now) * 1000.0 / frequency;
+    // Sleep while there is plenty of time left...
+    if (remaining > SPIN_MILLISECONDS)
+        SDL_Delay((Uint32)(remaining - SPIN_MILLISECONDS));
+    // ...then spin for the rest.
+    while (SDL_GetPerformanceCounter() < m_deadline) {
+    }
+}
+
+void FramePacer::Report(std::ostream& out) const {
+    double seconds = (double)(m_frameStart - m_firstFrameStart) / (double)SDL_GetPerformanceFrequency();
+    double averageFPS = (m_frameCount > 1 && seconds > 0.0) ? (double)(m_frameCount - 1) / seconds : 0.0;
+    out << "[FramePacer] mode: " << ModeName(m_mode);
+    if (m_mode != PacingMode::Unlimited)
+        out << " (" << expectedRate() << " Hz)";
+    out << "  frames: " << m_frameCount
+        << "  average FPS: " << averageFPS
+        << "  missed deadlines: " << m_missedDeadlines << "\n";
+}
+
+bool FramePacer::ParseMode(const std::string& name, PacingMode& mode) {
+    if (name == "unlimited")
+        mode = PacingMode::Unlimited;
+    else if (name == "fps")
+        mode = PacingMode::TargetFPS;
+    else if (name == "vsync")
+        mode = PacingMode::VSync;
+    else if (name == "adaptive")
+        mode = PacingMode::AdaptiveVSync;
+    else
+        return false;
+    return true;
+}
+
+const char* FramePacer::ModeName(PacingMode mode) {
+    switch (mode) {
+        case PacingMode::TargetFPS:
+            return "fps";
+        case PacingMode::VSync:
+            return "vsync";
+        case PacingMode::AdaptiveVSync:
+            return "adaptive";
+        default:
+            return "unlimited";
+    }
+}
+
+FixedTimestep::FixedTimestep(double rate, int maxSteps) : m_step(1.0 / ((rate > 0.0) ? rate : 120.0)), m_maxSteps(maxSteps), m_accumulator(0.0) {
+}
+
+int FixedTimestep::Advance(double seconds) {
+    m_accumulator += seconds;
+    int steps = 0;
+    while (m_accumulator >= m_step && steps < m_maxSteps) {
+        m_accumulator -= m_step;
+        steps++;
+    }
+    // Drop whatever could not be caught up with.
+    if (steps == m_maxSteps && m_accumulator >= m_step)
+        m_accumulator = 0.0;
+    return steps;
+}
@@ -0,0 +1,113 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+    #include <xmmintrin.h>
+    #define FRUSTUM_SSE
+#endif
+
+void BoxList::Add(const glm::vec3& min, const glm::vec3& max) {
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    extentX.push_back(extent.x);
+    extentY.push_back(extent.y);
+    extentZ.push_back(extent.z);
+}
+
+void BoxList::SetExtentY(float extent) {
+    for (float& e : extentY)
+        e = extent;
+}
+
+void BoxList::Clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+}
+
+// glm matrices are column major, so row i is m[0][i] .. m[3][i].
+Frustum::Frustum(const glm::mat4& m) {
+    glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+    glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+    glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+    glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+    m_planes[0] = row3 + row0;
+    m_planes[1] = row3 - row0;
+    m_planes[2] = row3 + row1;
+    m_planes[3] = row3 - row1;
+    m_planes[4] = row3 + row2;
+    m_planes[5] = row3 - row2;
+}
+
+// A box is outside a plane when even its corner furthest along the
+// plane's normal is behind it: dot(n, center) + d + dot(|n|, extent) < 0.
+bool Frustum::IsVisible(const glm::vec3& min, const glm::vec3& max) const {
+    glm::vec3 center = (min + max) * 0.5f;
+    glm::vec3 extent = (max - min) * 0.5f;
+    for (const glm::vec4& plane : m_planes) {
+        float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+        float radius = std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y + std::fabs(plane.z) * extent.z;
+        if (distance + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
+
+int Frustum::CullBoxes(const BoxList& boxes, std::vector<unsigned char>& visible) const {
+    int count = boxes.Size();
+    visible.resize(count);
+    int visibleCount = 0;
+    int i = 0;
+
+#if defined(FRUSTUM_SSE)
+    // Four boxes per iteration, one plane at a time.
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 cx = _mm_loadu_ps(&boxes.centerX[i]);
+        __m128 cy = _mm_loadu_ps(&boxes.centerY[i]);
+        __m128 cz = _mm_loadu_ps(&boxes.centerZ[i]);
+        __m128 ex = _mm_loadu_ps(&boxes.extentX[i]);
+        __m128 ey = _mm_loadu_ps(&boxes.extentY[i]);
+        __m128 ez = _mm_loadu_ps(&boxes.extentZ[i]);
+        __m128 inside = _mm_cmpeq_ps(zero, zero);
+        for (const glm::vec4& plane : m_planes) {
+            __m128 distance = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+            __m128 radius = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), ex), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), ey)),
+                _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), ez));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, radius), zero));
+        }
+        int mask = _mm_movemask_ps(inside);
+        for (int lane = 0; lane < 4; lane++) {
+            visible[i + lane] = (mask >> lane) & 1;
+            visibleCount += visible[i + lane];
+        }
+    }
+#endif
+
+    // The remaining boxes (or every box without SSE)
+    for (; i < count; i++) {
+        bool inside = true;
+        for (const glm::vec4& plane : m_planes) {
+            float distance = plane.x * boxes.centerX[i] + plane.y * boxes.centerY[i] + plane.z * boxes.centerZ[i] + plane.w;
+            float radius = std::fabs(plane.x) * boxes.extentX[i] + std::fabs(plane.y) * boxes.extentY[i]
+                         + std::fabs(plane.z) * boxes.extentZ[i];
+            if (distance + radius < 0.0f) {
+                inside = false;
+                break;
+            }
+        }
+        visible[i] = inside ? 1 : 0;
+        visibleCount += visible[i];
+    }
+    return visibleCount;
+}
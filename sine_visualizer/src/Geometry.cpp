@@ -1,6 +1,9 @@
 #include "Geometry.h"
+#include "GridIndices.h"
+#include "ThreadPool.h"
 #include <assert.h>
 #include <iostream>
+#include <limits>
 #include "glm/vec3.hpp"
 #include "glm/vec2.hpp"
 #include "glm/glm.hpp"
@@ -74,6 +77,7 @@ void Geometry::gen(){
     // Code will execute when a texture map was provided
     if (textureCoords.size() != 0) {
         assert((vertexPositions.size() / 3) == (textureCoords.size() / 2));
+        allData.reserve(allData.size() + (vertexPositions.size() / 3) * 14);
 
         int coordsPos = 0;
         for(int i =0; i < vertexPositions.size() / 3; i++){
@@ -101,6 +105,7 @@ void Geometry::gen(){
     }
     // Only push vertex positions if no texture was provided
     else {
+        allData.reserve(allData.size() + vertexPositions.size());
         for (int i = 0; i < vertexPositions.size() / 3; i++) {
             allData.push_back(vertexPositions[i * 3 + 0]);
             allData.push_back(vertexPositions[i * 3 + 1]);
@@ -109,6 +114,38 @@ void Geometry::gen(){
     }
 }
 
+// Number of floats each attribute takes
+static unsigned int attributeSize(unsigned int attribute) {
+    return (attribute == ATTRIBUTE_TEXCOORD) ? 2 : 3;
+}
+
+void Geometry::allocateVertices(unsigned int vertexCount, unsigned int attributes) {
+    m_attributes = attributes;
+    m_stride = 0;
+    for (unsigned int attribute = ATTRIBUTE_POSITION; attribute <= ATTRIBUTE_BITANGENT; attribute <<= 1) {
+        if (attributes & attribute)
+            m_stride += attributeSize(attribute);
+    }
+    // The separate streams are not used by the builder.
+    std::vector<float>().swap(vertexPositions);
+    std::vector<float>().swap(textureCoords);
+    std::vector<float>().swap(normals);
+    std::vector<float>().swap(Tangents);
+    std::vector<float>().swap(BiTangents);
+    // A single allocation, sized exactly.
+    std::vector<float>((size_t)vertexCount * m_stride).swap(allData);
+}
+
+unsigned int Geometry::getAttributeOffset(VertexAttribute attribute) {
+    assert(m_attributes & attribute);
+    unsigned int offset = 0;
+    for (unsigned int previous = ATTRIBUTE_POSITION; previous < (unsigned int)attribute; previous <<= 1) {
+        if (m_attributes & previous)
+            offset += attributeSize(previous);
+    }
+    return offset;
+}
+
 // The big trick here, is that when we make a triangle
 // We also need to update our normals, tangents, and bi-tangents.
 void Geometry::makeTriangle(unsigned int vert0, unsigned int vert1, unsigned int vert2) {
@@ -197,12 +234,100 @@ void Geometry::makeTriangle(unsigned int vert0, unsigned int vert1, unsigned int
     BiTangents[vert2*3+2] = bitangent.z;	
 }
 
+// Builds the strips of every row into a preallocated array, one band
+// of rows per task. The output does not depend on the thread count.
+template <typename IndexType>
+static void buildGridStrips(int xVertices, int zVertices, std::vector<IndexType>& out) {
+    out.resize(GridStripBuilder<IndexType>::IndexCount(xVertices, zVertices));
+    IndexType* data = out.data();
+    // Strip rows are cheap, so bands of fewer rows than this are not
+    // worth handing to another thread.
+    const int ROW_GRAIN = 16;
+    ThreadPool::Get().ParallelFor(zVertices - 1, ROW_GRAIN, [=](int firstRow, int lastRow) {
+        GridStripBuilder<IndexType>::BuildRows(xVertices, zVertices, firstRow, lastRow, data);
+    });
+}
+
+// The index type is chosen at runtime, and each size uses its own
+// instantiation of the builder.
+void Geometry::makeGridStrips(int xVertices, int zVertices) {
+    indices.clear();
+    shortIndices.clear();
+    if (GridStripBuilder<unsigned short>::Fits(xVertices, zVertices)) {
+        buildGridStrips(xVertices, zVertices, shortIndices);
+    } else {
+        buildGridStrips(xVertices, zVertices, indices);
+    }
+    m_primitiveRestart = true;
+}
+
 // Returns number of indicies
 unsigned int Geometry::getIndicesSize(){
-    return indices.size();
+    return shortIndices.empty() ? indices.size() : shortIndices.size();
+}
+
+const void* Geometry::getIndexBytes(){
+    return shortIndices.empty() ? (const void*)indices.data() : (const void*)shortIndices.data();
+}
+
+unsigned int Geometry::getIndexTypeSize(){
+    return shortIndices.empty() ? sizeof(unsigned int) : sizeof(unsigned short);
 }
 
 // Returns raw indicies data
 unsigned int* Geometry::getIndicesData(){
     return indices.data();
 }
+
+// Appends the triangles of one strip, flipping every other one so all
+// of them keep the strip's winding.
+template <typename IndexType>
+static void appendStrip(const IndexType* strip, size_t count, std::vector<unsigned int>& out) {
+    for (size_t i = 2; i < count; i++) {
+        unsigned int a = strip[i - 2];
+        unsigned int b = strip[i - 1];
+        unsigned int c = strip[i];
+        if (a == b || b == c || a == c)
+            continue;
+        if (i % 2 == 0) {
+            out.insert(out.end(), {a, b, c});
+        } else {
+            out.insert(out.end(), {b, a, c});
+        }
+    }
+}
+
+template <typename IndexType>
+static std::vector<unsigned int> toTriangleList(const std::vector<IndexType>& indices, bool triangleList, bool primitiveRestart) {
+    if (triangleList)
+        return std::vector<unsigned int>(indices.begin(), indices.end());
+    std::vector<unsigned int> triangles;
+    triangles.reserve(indices.size() * 3);
+    const IndexType restart = std::numeric_limits<IndexType>::max();
+    size_t start = 0;
+    for (size_t i = 0; i <= indices.size(); i++) {
+        if (i == indices.size() || (primitiveRestart && indices[i] == restart)) {
+            appendStrip(indices.data() + start, i - start, triangles);
+            start = i + 1;
+        }
+    }
+    return triangles;
+}
+
+std::vector<unsigned int> Geometry::getTriangleList(){
+    if (!shortIndices.empty())
+        return toTriangleList(shortIndices, m_triangleList, m_primitiveRestart);
+    return toTriangleList(indices, m_triangleList, m_primitiveRestart);
+}
+
+void Geometry::optimizeVertexCache(int cacheSize){
+    std::vector<unsigned int> triangles = getTriangleList();
+    VertexCache::Optimize(triangles, cacheSize);
+    if (!shortIndices.empty()) {
+        shortIndices.assign(triangles.begin(), triangles.end());
+    } else {
+        indices.swap(triangles);
+    }
+    m_primitiveRestart = false;
+    m_triangleList = true;
+}
@@ -0,0 +1,130 @@
+#include "HeadlessContext.h"
+
+#include <iostream>
+
+#if defined(LINUX)
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#endif
+
+HeadlessContext::HeadlessContext() : m_display(nullptr), m_surface(nullptr), m_context(nullptr) {
+    std::cout << "(HeadlessContext.cpp) Constructor Called\n";
+}
+
+HeadlessContext::~HeadlessContext() {
+#if defined(LINUX)
+    if (m_display != nullptr) {
+        EGLDisplay display = (EGLDisplay)m_display;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_context != nullptr)
+            eglDestroyContext(display, (EGLContext)m_context);
+        if (m_surface != nullptr)
+            eglDestroySurface(display, (EGLSurface)m_surface);
+        eglTerminate(display);
+    }
+#endif
+}
+
+bool HeadlessContext::Create(int width, int height, int majorVersion, int minorVersion, std::string& error) {
+#if defined(LINUX)
+    // Prefer the surfaceless platform, which needs neither X11 nor a GPU
+    // device node. Fall back to the default display otherwise.
+    EGLDisplay display = EGL_NO_DISPLAY;
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+        (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (getPlatformDisplay != nullptr)
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY) {
+        error = "Could not get an EGL display";
+        return false;
+    }
+
+    EGLint major, minor;
+    if (!eglInitialize(display, &major, &minor)) {
+        error = "Could not initialize EGL";
+        return false;
+    }
+    m_display = display;
+    std::cout << "EGL version: " << major << "." << minor << "\n";
+
+    // Match the attributes requested from SDL for the window.
+    const EGLint configAttributes[] = {
+        EGL_SURFACE_TYPE,    EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE,        8,
+        EGL_GREEN_SIZE,      8,
+        EGL_BLUE_SIZE,       8,
+        EGL_DEPTH_SIZE,      24,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &numConfigs) || numConfigs == 0) {
+        error = "No EGL config supports OpenGL pbuffers";
+        return false;
+    }
+
+    const EGLint surfaceAttributes[] = {
+        EGL_WIDTH,  width,
+        EGL_HEIGHT, height,
+        EGL_NONE
+    };
+    EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+    if (surface == EGL_NO_SURFACE) {
+        error = "Could not create an EGL pbuffer surface";
+        return false;
+    }
+    m_surface = surface;
+
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+        error = "EGL does not support the OpenGL API";
+        return false;
+    }
+
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION,       majorVersion,
+        EGL_CONTEXT_MINOR_VERSION,       minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT) {
+        error = "Could not create an EGL OpenGL context";
+        return false;
+    }
+    m_context = context;
+
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+        error = "Could not make the EGL context current";
+        return false;
+    }
+    return true;
+#else
+    error = "Headless mode is only supported on Linux";
+    return false;
+#endif
+}
+
+void HeadlessContext::SwapBuffers() {
+#if defined(LINUX)
+    if (m_display != nullptr && m_surface != nullptr)
+        eglSwapBuffers((EGLDisplay)m_display, (EGLSurface)m_surface);
+#endif
+}
+
+void HeadlessContext::SetSwapInterval(int interval) {
+#if defined(LINUX)
+    if (m_display != nullptr)
+        eglSwapInterval((EGLDisplay)m_display, interval);
+#endif
+}
+
+void* HeadlessContext::GetProcAddress(const char* name) {
+#if defined(LINUX)
+    return (void*)eglGetProcAddress(name);
+#else
+    return nullptr;
+#endif
+}
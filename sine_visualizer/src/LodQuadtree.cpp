@@ -0,0 +1,95 @@
+#include "LodQuadtree.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Stands in for an infinite range, while keeping the morph math finite
+static const float UNLIMITED_RANGE = 1.0e30f;
+
+// Distance from a point to the closest point of a box
+static float distanceToBox(const glm::vec3& point, const glm::vec3& min, const glm::vec3& max) {
+    glm::vec3 d = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+    return glm::length(d);
+}
+
+LodQuadtree::LodQuadtree() : m_patchQuads(1), m_levels(0), m_rootCorner(0.0f), m_rootSize(0.0f), m_planeMin(0.0f), m_planeMax(0.0f) {
+}
+
+void LodQuadtree::Create(int xSegments, int zSegments, int patchQuads) {
+    m_patchQuads = patchQuads;
+    m_planeMin = glm::vec2(-xSegments / 2.0f, -zSegments / 2.0f);
+    m_planeMax = glm::vec2(xSegments - 1 - xSegments / 2.0f, zSegments - 1 - zSegments / 2.0f);
+
+    // The root is the smallest power of two of patches that covers
+    // the whole plane.
+    float extent = std::max(m_planeMax.x - m_planeMin.x, m_planeMax.y - m_planeMin.y);
+    m_levels = 1;
+    m_rootSize = (float)patchQuads;
+    while (m_rootSize < extent) {
+        m_rootSize *= 2.0f;
+        m_levels++;
+    }
+    m_rootCorner = m_planeMin;
+    SetBaseRange(0.0f);
+}
+
+void LodQuadtree::SetBaseRange(float range) {
+    // A range shorter than a patch's diagonal could not hold a whole
+    // morph band.
+    float minimum = 2.0f * m_patchQuads;
+    if (range <= 0.0f)
+        range = 3.0f * m_patchQuads;
+    range = std::max(range, minimum);
+
+    m_ranges.resize(m_levels);
+    for (int level = 0; level < m_levels; level++)
+        m_ranges[level] = range * std::pow(2.0f, (float)level);
+    // The root is always in range, so something is always drawn.
+    m_ranges[m_levels - 1] = UNLIMITED_RANGE;
+}
+
+glm::vec2 LodQuadtree::GetMorphRange(int level) const {
+    if (level >= m_levels - 1)
+        return glm::vec2(UNLIMITED_RANGE, 2.0f * UNLIMITED_RANGE);
+    float previous = (level > 0) ? m_ranges[level - 1] : 0.0f;
+    float end = m_ranges[level];
+    return glm::vec2(previous + (end - previous) * MORPH_START, end);
+}
+
+void LodQuadtree::Select(const glm::vec3& eye, const Frustum& frustum, float maxHeight, std::vector<LodPatch>& patches) const {
+    patches.clear();
+    if (m_levels == 0)
+        return;
+    SelectNode(m_rootCorner.x, m_rootCorner.y, m_rootSize, m_levels - 1, eye, frustum, maxHeight, patches);
+}
+
+bool LodQuadtree::SelectNode(float x, float z, float size, int level, const glm::vec3& eye,
+                             const Frustum& frustum, float maxHeight, std::vector<LodPatch>& patches) const {
+    // Only the part of the node that is on the plane matters.
+    glm::vec3 min(std::max(x, m_planeMin.x), 0.0f, std::max(z, m_planeMin.y));
+    glm::vec3 max(std::min(x + size, m_planeMax.x), 0.0f, std::min(z + size, m_planeMax.y));
+    if (min.x >= max.x || min.z >= max.z)
+        return true;
+    if (!frustum.IsVisible(min - glm::vec3(0.0f, maxHeight, 0.0f), max + glm::vec3(0.0f, maxHeight, 0.0f)))
+        return true;
+
+    // Ranges are measured to the flat plane, like the morph in the
+    // vertex shader.
+    float distance = distanceToBox(eye, min, max);
+    if (distance > m_ranges[level])
+        return false;
+
+    if (level == 0 || distance > m_ranges[level - 1]) {
+        patches.push_back({ x, z, size, level, -1 });
+        return true;
+    }
+
+    float half = size / 2.0f;
+    for (int quadrant = 0; quadrant < 4; quadrant++) {
+        float childX = x + (quadrant & 1) * half;
+        float childZ = z + (quadrant >> 1) * half;
+        if (!SelectNode(childX, childZ, half, level - 1, eye, frustum, maxHeight, patches))
+            patches.push_back({ x, z, size, level, quadrant });
+    }
+    return true;
+}
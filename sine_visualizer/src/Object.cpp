@@ -68,17 +68,27 @@ void Object::Bind(){
 void Object::render(){
         Bind();
 
+        GLenum indexType = (geometry.getIndexTypeSize() == sizeof(unsigned short)) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        // Strips are separated by the largest index of the type,
+        // the same index GL_PRIMITIVE_RESTART_FIXED_INDEX uses.
+        if (geometry.usesPrimitiveRestart()) {
+                glEnable(GL_PRIMITIVE_RESTART);
+                glPrimitiveRestartIndex((indexType == GL_UNSIGNED_SHORT) ? 0xFFFF : 0xFFFFFFFF);
+        }
+
         if (m_renderMode == "points") {
                 //Render data
                 glDrawElements(GL_POINTS,
                         geometry.getIndicesSize(),               // The number of indicies, not triangles.
-                        GL_UNSIGNED_INT, // Make sure the data type matches
+                        indexType,       // Make sure the data type matches
                         nullptr);        // Offset pointer to the data. nullptr because we are currently bound:	
         } else {
-                glDrawElements(GL_TRIANGLE_STRIP,
+                glDrawElements(geometry.isTriangleList() ? GL_TRIANGLES : GL_TRIANGLE_STRIP,
                         geometry.getIndicesSize(),
-                        GL_UNSIGNED_INT,
+                        indexType,
                         nullptr);
         }
-}
 
+        if (geometry.usesPrimitiveRestart())
+                glDisable(GL_PRIMITIVE_RESTART);
+}
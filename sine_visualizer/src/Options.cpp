@@ -0,0 +1,433 @@
+#include "Options.h"
+#include "FrameBuffer.h"
+#include "FramePacer.h"
+#include "SceneNode.h"
+#include "Terrain.h"
+
+#include <cstdlib>
+#include <iostream>
+
+// Reads the value following a flag as an int.
+static bool readInt(int argc, char** argv, int& i, int& value) {
+    if (i + 1 >= argc) {
+        std::cout << "(Options.cpp) Missing value for " << argv[i] << "\n";
+        return false;
+    }
+    char* end = nullptr;
+    long parsed = std::strtol(argv[i + 1], &end, 10);
+    if (end == argv[i + 1] || *end != '\0') {
+        std::cout << "(Options.cpp) Invalid integer for " << argv[i] << ": " << argv[i + 1] << "\n";
+        return false;
+    }
+    value = (int)parsed;
+    ++i;
+    return true;
+}
+
+// Reads the value following a flag as a float.
+static bool readFloat(int argc, char** argv, int& i, float& value) {
+    if (i + 1 >= argc) {
+        std::cout << "(Options.cpp) Missing value for " << argv[i] << "\n";
+        return false;
+    }
+    char* end = nullptr;
+    float parsed = std::strtof(argv[i + 1], &end);
+    if (end == argv[i + 1] || *end != '\0') {
+        std::cout << "(Options.cpp) Invalid number for " << argv[i] << ": " << argv[i + 1] << "\n";
+        return false;
+    }
+    value = parsed;
+    ++i;
+    return true;
+}
+
+// Reads the value following a flag as a string.
+static bool readString(int argc, char** argv, int& i, std::string& value) {
+    if (i + 1 >= argc) {
+        std::cout << "(Options.cpp) Missing value for " << argv[i] << "\n";
+        return false;
+    }
+    value = argv[i + 1];
+    ++i;
+    return true;
+}
+
+// Reads the value following a flag as a comma separated list of ints.
+static bool readIntList(int argc, char** argv, int& i, std::vector<int>& values) {
+    if (i + 1 >= argc) {
+        std::cout << "(Options.cpp) Missing value for " << argv[i] << "\n";
+        return false;
+    }
+    std::vector<int> parsedValues;
+    const char* cursor = argv[i + 1];
+    while (*cursor != '\0') {
+        char* end = nullptr;
+        long parsed = std::strtol(cursor, &end, 10);
+        if (end == cursor || (*end != ',' && *end != '\0') || parsed <= 0) {
+            std::cout << "(Options.cpp) Invalid list for " << argv[i] << ": " << argv[i + 1] << "\n";
+            return false;
+        }
+        parsedValues.push_back((int)parsed);
+        cursor = (*end == ',') ? end + 1 : end;
+    }
+    if (parsedValues.empty()) {
+        std::cout << "(Options.cpp) Empty list for " << argv[i] << "\n";
+        return false;
+    }
+    values = parsedValues;
+    ++i;
+    return true;
+}
+
+// Reads the value following a flag as a comma separated list of
+// strings.
+static bool readStringList(int argc, char** argv, int& i, std::vector<std::string>& values) {
+    if (i + 1 >= argc) {
+        std::cout << "(Options.cpp) Missing value for " << argv[i] << "\n";
+        return false;
+    }
+    std::vector<std::string> parsedValues;
+    std::string list = argv[i + 1];
+    size_t start = 0;
+    while (start <= list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos)
+            end = list.size();
+        if (end == start) {
+            std::cout << "(Options.cpp) Invalid list for " << argv[i] << ": " << argv[i + 1] << "\n";
+            return false;
+        }
+        parsedValues.push_back(list.substr(start, end - start));
+        start = end + 1;
+    }
+    values = parsedValues;
+    ++i;
+    return true;
+}
+
+bool parseOptions(int argc, char** argv, ProgramOptions& options) {
+    // Positional arguments keep the original behavior of passing
+    // a texture, followed by a height map.
+    int positional = 0;
+    bool ok = true;
+
+    for (int i = 1; i < argc && ok; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        } else if (arg == "--headless") {
+            options.headless = true;
+        } else if (arg == "--width") {
+            ok = readInt(argc, argv, i, options.windowWidth);
+        } else if (arg == "--height") {
+            ok = readInt(argc, argv, i, options.windowHeight);
+        } else if (arg == "--x" || arg == "--z") {
+            int& segments = (arg == "--x") ? options.terrainX : options.terrainZ;
+            ok = readInt(argc, argv, i, segments);
+            if (ok && (segments < 2 || segments > Terrain::MAX_SEGMENTS)) {
+                std::cout << "(Options.cpp) " << arg << " must be between 2 and " << Terrain::MAX_SEGMENTS << "\n";
+                ok = false;
+            }
+        } else if (arg == "--amplitude") {
+            ok = readFloat(argc, argv, i, options.amplitude);
+        } else if (arg == "--wave-number") {
+            ok = readFloat(argc, argv, i, options.waveNumber);
+        } else if (arg == "--wave-period") {
+            ok = readFloat(argc, argv, i, options.wavePeriod);
+        } else if (arg == "--plane-mode") {
+            ok = readString(argc, argv, i, options.planeMode);
+            if (ok && options.planeMode != "yAxis" && options.planeMode != "xyAxis" && options.planeMode != "flat") {
+                std::cout << "(Options.cpp) Unknown plane mode: " << options.planeMode << "\n";
+                ok = false;
+            }
+        } else if (arg == "--grid") {
+            ok = readString(argc, argv, i, options.gridMode);
+            GridMode mode;
+            if (ok && !Terrain::ParseGridMode(options.gridMode, mode)) {
+                std::cout << "(Options.cpp) Unknown grid mode: " << options.gridMode << "\n";
+                ok = false;
+            }
+        } else if (arg == "--lighting") {
+            ok = readString(argc, argv, i, options.lighting);
+            LightingMode mode;
+            if (ok && !SceneNode::ParseLightingMode(options.lighting, mode)) {
+                std::cout << "(Options.cpp) Unknown lighting mode: " << options.lighting << "\n";
+                ok = false;
+            }
+        } else if (arg == "--tile-size") {
+            ok = readInt(argc, argv, i, options.tileSize);
+            if (ok && options.tileSize < 1) {
+                std::cout << "(Options.cpp) " << arg << " must be positive\n";
+                ok = false;
+            }
+        } else if (arg == "--lod-patch") {
+            ok = readInt(argc, argv, i, options.lodPatch);
+            if (ok && (options.lodPatch < 2 || options.lodPatch > 128)) {
+                std::cout << "(Options.cpp) " << arg << " must be between 2 and 128\n";
+                ok = false;
+            }
+        } else if (arg == "--lod-range") {
+            ok = readFloat(argc, argv, i, options.lodRange);
+            if (ok && options.lodRange < 0.0f) {
+                std::cout << "(Options.cpp) " << arg << " can not be negative\n";
+                ok = false;
+            }
+        } else if (arg == "--tess-patch") {
+            ok = readInt(argc, argv, i, options.tessPatch);
+            if (ok && (options.tessPatch < 1 || options.tessPatch > 64)) {
+                std::cout << "(Options.cpp) " << arg << " must be between 1 and 64\n";
+                ok = false;
+            }
+        } else if (arg == "--tess-pixels") {
+            ok = readFloat(argc, argv, i, options.tessPixels);
+            if (ok && options.tessPixels <= 0.0f) {
+                std::cout << "(Options.cpp) " << arg << " must be positive\n";
+                ok = false;
+            }
+        } else if (arg == "--tess-error") {
+            ok = readFloat(argc, argv, i, options.tessError);
+            if (ok && options.tessError <= 0.0f) {
+                std::cout << "(Options.cpp) " << arg << " must be positive\n";
+                ok = false;
+            }
+        } else if (arg == "--projected-cell") {
+            ok = readInt(argc, argv, i, options.projectedCell);
+            if (ok && options.projectedCell < 1) {
+                std::cout << "(Options.cpp) " << arg << " must be positive\n";
+                ok = false;
+            }
+        } else if (arg == "--instance-patch") {
+            ok = readInt(argc, argv, i, options.instancePatch);
+            if (ok && (options.instancePatch < 1 || options.instancePatch > 128)) {
+                std::cout << "(Options.cpp) " << arg << " must be between 1 and 128\n";
+                ok = false;
+            }
+        } else if (arg == "--vertex-cache") {
+            options.vertexCache = true;
+        } else if (arg == "--shader-cache") {
+            ok = readString(argc, argv, i, options.shaderCacheDir);
+        } else if (arg == "--no-shader-cache") {
+            options.shaderCacheDir.clear();
+        } else if (arg == "--render-mode") {
+            ok = readString(argc, argv, i, options.renderMode);
+            if (ok && options.renderMode != "triStrip" && options.renderMode != "points") {
+                std::cout << "(Options.cpp) Unknown render mode: " << options.renderMode << "\n";
+                ok = false;
+            }
+        } else if (arg == "--effect") {
+            ok = readStringList(argc, argv, i, options.effects);
+            for (size_t e = 0; ok && e < options.effects.size(); e++) {
+                if (!Framebuffer::IsEffect(options.effects[e])) {
+                    std::cout << "(Options.cpp) Unknown effect: " << options.effects[e] << "\n";
+                    ok = false;
+                }
+            }
+        } else if (arg == "--frames") {
+            ok = readInt(argc, argv, i, options.frames);
+        } else if (arg == "--output") {
+            ok = readString(argc, argv, i, options.outputPath);
+        } else if (arg == "--benchmark") {
+            options.benchmark = true;
+        } else if (arg == "--bench-sizes") {
+            ok = readIntList(argc, argv, i, options.benchSizes);
+        } else if (arg == "--bench-grids") {
+            ok = readStringList(argc, argv, i, options.benchGrids);
+            GridMode mode;
+            for (size_t g = 0; ok && g < options.benchGrids.size(); g++) {
+                if (!Terrain::ParseGridMode(options.benchGrids[g], mode)) {
+                    std::cout << "(Options.cpp) Unknown grid mode: " << options.benchGrids[g] << "\n";
+                    ok = false;
+                }
+            }
+        } else if (arg == "--bench-lighting") {
+            ok = readStringList(argc, argv, i, options.benchLighting);
+            LightingMode mode;
+            for (size_t l = 0; ok && l < options.benchLighting.size(); l++) {
+                if (!SceneNode::ParseLightingMode(options.benchLighting[l], mode)) {
+                    std::cout << "(Options.cpp) Unknown lighting mode: " << options.benchLighting[l] << "\n";
+                    ok = false;
+                }
+            }
+        } else if (arg == "--bench-frames") {
+            ok = readInt(argc, argv, i, options.benchFrames);
+        } else if (arg == "--bench-warmup") {
+            ok = readInt(argc, argv, i, options.benchWarmup);
+        } else if (arg == "--bench-json") {
+            ok = readString(argc, argv, i, options.benchJSON);
+        } else if (arg == "--bench-csv") {
+            ok = readString(argc, argv, i, options.benchCSV);
+        } else if (arg == "--profile") {
+            options.profile = true;
+        } else if (arg == "--profile-interval") {
+            float interval = 0.0f;
+            ok = readFloat(argc, argv, i, interval);
+            options.profileInterval = interval;
+        } else if (arg == "--profile-file") {
+            ok = readString(argc, argv, i, options.profileFile);
+            options.profile = true;
+        } else if (arg == "--pacing") {
+            ok = readString(argc, argv, i, options.pacing);
+            PacingMode mode;
+            if (ok && !FramePacer::ParseMode(options.pacing, mode)) {
+                std::cout << "(Options.cpp) Unknown pacing mode: " << options.pacing << "\n";
+                ok = false;
+            }
+        } else if (arg == "--fps") {
+            float fps = 0.0f;
+            ok = readFloat(argc, argv, i, fps);
+            if (ok && fps <= 0.0f) {
+                std::cout << "(Options.cpp) " << arg << " must be positive\n";
+                ok = false;
+            }
+            options.targetFPS = fps;
+            if (options.pacing.empty())
+                options.pacing = "fps";
+        } else if (arg == "--sim-rate") {
+            float rate = 0.0f;
+            ok = readFloat(argc, argv, i, rate);
+            if (ok && rate <= 0.0f) {
+                std::cout << "(Options.cpp) " << arg << " must be positive\n";
+                ok = false;
+            }
+            options.simulationRate = rate;
+        } else if (arg == "--build-bench") {
+            ok = readIntList(argc, argv, i, options.buildBenchSizes);
+        } else if (arg == "--build-threads") {
+            ok = readInt(argc, argv, i, options.buildThreads);
+            if (ok && options.buildThreads < 0) {
+                std::cout << "(Options.cpp) " << arg << " can not be negative\n";
+                ok = false;
+            }
+        } else if (arg == "--cache-report") {
+            ok = readIntList(argc, argv, i, options.cacheReportSizes);
+            for (size_t s = 0; ok && s < options.cacheReportSizes.size(); s++) {
+                // A plane of one segment has no triangles to measure.
+                if (options.cacheReportSizes[s] < 2 || options.cacheReportSizes[s] > Terrain::MAX_SEGMENTS) {
+                    std::cout << "(Options.cpp) " << arg << " sizes must be between 2 and " << Terrain::MAX_SEGMENTS << "\n";
+                    ok = false;
+                }
+            }
+        } else if (arg == "--clock-soak") {
+            float days = 0.0f;
+            ok = readFloat(argc, argv, i, days);
+            if (ok && days <= 0.0f) {
+                std::cout << "(Options.cpp) " << arg << " must be positive\n";
+                ok = false;
+            }
+            options.clockSoakDays = days;
+        } else if (arg == "--trace") {
+            ok = readString(argc, argv, i, options.traceFile);
+        } else if (arg == "--trace-capacity") {
+            ok = readInt(argc, argv, i, options.traceCapacity);
+            if (ok && options.traceCapacity < 1) {
+                std::cout << "(Options.cpp) " << arg << " must be positive\n";
+                ok = false;
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cout << "(Options.cpp) Unknown option: " << arg << "\n";
+            ok = false;
+        } else if (positional == 0) {
+            options.texturePath = arg;
+            positional++;
+        } else if (positional == 1) {
+            options.terrainPath = arg;
+            positional++;
+        } else {
+            std::cout << "(Options.cpp) Unexpected argument: " << arg << "\n";
+            ok = false;
+        }
+    }
+
+    if (ok && options.frames < 1) {
+        std::cout << "(Options.cpp) --frames must be at least 1\n";
+        ok = false;
+    }
+    if (ok && (options.benchFrames < 1 || options.benchWarmup < 0)) {
+        std::cout << "(Options.cpp) --bench-frames must be at least 1 and --bench-warmup at least 0\n";
+        ok = false;
+    }
+
+    // Headless and benchmark runs cannot prompt, so fall back to
+    // sensible sizes for anything that was not passed in.
+    if (ok && (options.headless || options.benchmark)) {
+        if (options.windowWidth <= 0)  options.windowWidth = 1280;
+        if (options.windowHeight <= 0) options.windowHeight = 720;
+        if (options.terrainX <= 0)     options.terrainX = 100;
+        if (options.terrainZ <= 0)     options.terrainZ = 100;
+    }
+
+    if (!ok)
+        printUsage(argv[0]);
+
+    return ok;
+}
+
+void printUsage(const char* executable) {
+    std::cout << "Usage: " << executable << " [options] [texture.ppm] [heightmap.ppm]\n"
+              << "\n"
+              << "  --width N            Window width (prompted if omitted)\n"
+              << "  --height N           Window height (prompted if omitted)\n"
+              << "  --x N                Plane X dimension (prompted if omitted)\n"
+              << "  --z N                Plane Z dimension (prompted if omitted)\n"
+              << "  --amplitude F        Initial wave amplitude (default 100)\n"
+              << "  --wave-number F      Initial wave number (default 0.5)\n"
+              << "  --wave-period F      Initial wave period (default 50)\n"
+              << "  --plane-mode M       yAxis, xyAxis, or flat (default yAxis)\n"
+              << "  --render-mode M      triStrip or points (default triStrip)\n"
+              << "  --grid MODE          vertexBuffer, procedural (positions from gl_VertexID, no buffers),\n"
+              << "                       tiles (one buffer per tile, tiles outside the view are culled),\n"
+              << "                       lod (patches get coarser with distance to the camera),\n"
+              << "                       tessellation (patches split on the GPU, needs OpenGL 4.0),\n"
+              << "                       projected (a screen grid projected onto an endless plane),\n"
+              << "                       or instanced (one small patch drawn once per part of the plane)\n"
+              << "  --tile-size N        Quads along each side of a tile (default 64)\n"
+              << "  --lod-patch N        Quads along each side of a LOD patch, a power of two (default 32)\n"
+              << "  --lod-range F        Distance the finest LOD level reaches (default 0 = 3 patches)\n"
+              << "  --tess-patch N       Quads along each side of a tessellation patch, up to 64 (default 32)\n"
+              << "  --tess-pixels F      Shortest tessellated segment in pixels (default 8)\n"
+              << "  --tess-error F       Largest gap between a segment and the wave (default 0.5)\n"
+              << "  --projected-cell N   Pixels between the vertices of the projected grid (default 4)\n"
+              << "  --instance-patch N   Quads along each side of an instanced patch, up to 128 (default 64)\n"
+              << "  --vertex-cache       Draw the vertexBuffer, tiles, and instanced grids as triangle lists\n"
+              << "                       ordered for the GPU vertex cache\n"
+              << "  --lighting MODE      tangent (lights passed per vertex in tangent space) or world\n"
+              << "                       (only the world position and normal passed) (default tangent)\n"
+              << "  --effect LIST        Comma separated post effects, run in order: standard,\n"
+              << "                       grayscale, blur, invertColors, sharpen, edgeDetection\n"
+              << "  --shader-cache DIR   Save linked shader programs to DIR and load them on the next start\n"
+              << "                       instead of compiling (default ./shader_cache, needs OpenGL 4.1)\n"
+              << "  --no-shader-cache    Always compile the shaders\n"
+              << "\n"
+              << "  --headless           Render offscreen without a window and exit\n"
+              << "  --frames N           Frames to render in headless mode (default 1)\n"
+              << "  --output FILE.ppm    Save the last headless frame\n"
+              << "\n"
+              << "  --benchmark          Render a fixed camera path at several grid sizes\n"
+              << "                       without frame delay or vsync, then exit\n"
+              << "  --bench-sizes LIST   Comma separated square grid sizes (default 256,1024)\n"
+              << "  --bench-grids LIST   Comma separated grid modes to compare at every size\n"
+              << "                       (default: only the --grid mode)\n"
+              << "  --bench-lighting LIST Comma separated lighting modes to compare with every grid\n"
+              << "                       (default: only the --lighting mode)\n"
+              << "  --bench-frames N     Measured frames per size (default 300)\n"
+              << "  --bench-warmup N     Unmeasured frames per size (default 30)\n"
+              << "  --bench-json FILE    Write results as JSON\n"
+              << "  --bench-csv FILE     Write results as CSV\n"
+              << "\n"
+              << "  --profile            Time every render pass on the CPU and GPU\n"
+              << "  --profile-interval S Seconds between console reports (default 1, 0 = off)\n"
+              << "  --profile-file FILE  Append every report to a CSV file (implies --profile)\n"
+              << "\n"
+              << "  --pacing MODE        vsync, adaptive, fps, or unlimited (default vsync, unlimited headless)\n"
+              << "  --fps N              Target frame rate of the fps mode (default 60, implies --pacing fps)\n"
+              << "  --sim-rate N         Fixed simulation steps per second (default 120)\n"
+              << "  --build-bench LIST   Time building the plane geometry at each size, and exit\n"
+              << "  --build-threads N    Threads that build geometry (default 0 = one per core)\n"
+              << "  --cache-report LIST  Print the vertex cache ACMR and ATVR of the plane at each size, and exit\n"
+              << "  --clock-soak DAYS    Simulate DAYS of uptime, check the wave phases stay exact, and exit\n"
+              << "  --trace FILE         Record a timeline and write it as Chrome trace JSON on exit\n"
+              << "  --trace-capacity N   Events kept in the timeline (default 65536)\n"
+              << "  --help               Show this message\n";
+}
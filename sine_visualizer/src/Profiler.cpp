@@ -0,0 +1,272 @@
+#if defined(LINUX) || defined(MINGW)
+    #include <SDL2/SDL.h>
+#else // This works for Mac
+    #include <SDL.h>
+#endif
+
+#include "Profiler.h"
+
+#include <iomanip>
+#include <iostream>
+
+// Converts a performance counter difference into milliseconds
+static double ticksToMilliseconds(unsigned long long ticks) {
+    return (double)ticks * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+Profiler& Profiler::Get() {
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::Profiler() : m_enabled(false), m_frameStart(0), m_currentFrame(0), m_reportInterval(0.0), m_lastReport(0), m_startTime(0) {
+}
+
+Profiler::~Profiler() {
+    // Query objects are released in Shutdown(), while the context
+    // still exists.
+}
+
+void Profiler::Shutdown() {
+    for (int i = 0; i < FRAMES_IN_FLIGHT; i++) {
+        FrameQueries& frame = m_frames[i];
+        if (!frame.pool.empty())
+            glDeleteQueries(frame.pool.size(), frame.pool.data());
+        frame.pool.clear();
+        frame.records.clear();
+        frame.used = 0;
+        frame.pending = false;
+    }
+    m_enabled = false;
+}
+
+void Profiler::SetEnabled(bool enabled) {
+    m_enabled = enabled;
+    m_startTime = SDL_GetPerformanceCounter();
+    m_lastReport = m_startTime;
+}
+
+void Profiler::SetStatFile(const std::string& filepath) {
+    if (m_statFile.is_open())
+        m_statFile.close();
+    m_statFile.open(filepath.c_str());
+    if (!m_statFile.is_open()) {
+        std::cout << "ERROR - Unable to open stat file: " << filepath << "\n";
+        return;
+    }
+    m_statFile << "time_s,section,cpu_avg_ms,gpu_avg_ms,cpu_last_ms,gpu_last_ms,samples\n";
+}
+
+int Profiler::GetSectionID(const std::string& name) {
+    for (size_t i = 0; i < m_sections.size(); i++) {
+        if (m_sections[i].name == name)
+            return (int)i;
+    }
+    Section section;
+    section.name = name;
+    m_sections.push_back(section);
+    return (int)m_sections.size() - 1;
+}
+
+void Profiler::BeginFrame() {
+    if (Trace::Get().IsEnabled())
+        m_frameStart = SDL_GetPerformanceCounter();
+    if (!m_enabled)
+        return;
+
+    // This slot was last used FRAMES_IN_FLIGHT frames ago. If the GPU
+    // still has not finished it, its samples are dropped rather than
+    // waiting.
+    FrameQueries& frame = m_frames[m_currentFrame];
+    if (frame.pending)
+        Collect(frame);
+    frame.used = 0;
+    frame.records.clear();
+    frame.pending = false;
+
+    for (Section& section : m_sections) {
+        section.cpuFrame = 0.0;
+        section.timedThisFrame = false;
+    }
+}
+
+void Profiler::EndFrame() {
+    if (Trace::Get().IsEnabled() && m_frameStart != 0)
+        Trace::Get().RecordFrame(m_frameStart, SDL_GetPerformanceCounter());
+    if (!m_enabled)
+        return;
+
+    for (Section& section : m_sections) {
+        if (section.timedThisFrame)
+            section.cpu.Add(section.cpuFrame);
+    }
+
+    FrameQueries& frame = m_frames[m_currentFrame];
+    frame.pending = !frame.records.empty();
+    m_currentFrame = (m_currentFrame + 1) % FRAMES_IN_FLIGHT;
+
+    MaybeReport();
+}
+
+void Profiler::BeginSection(int id) {
+    Section& section = m_sections[id];
+    // Only the outermost call of a recursive section is timed.
+    if (section.depth++ > 0)
+        return;
+
+    section.cpuStart = SDL_GetPerformanceCounter();
+
+    FrameQueries& frame = m_frames[m_currentFrame];
+    GpuRecord record;
+    record.section = id;
+    record.begin = NextQuery();
+    record.end = 0;
+    glQueryCounter(record.begin, GL_TIMESTAMP);
+    section.openRecord = (int)frame.records.size();
+    frame.records.push_back(record);
+}
+
+void Profiler::EndSection(int id) {
+    Section& section = m_sections[id];
+    if (section.depth == 0 || --section.depth > 0)
+        return;
+
+    section.cpuFrame += ticksToMilliseconds(SDL_GetPerformanceCounter() - section.cpuStart);
+    section.timedThisFrame = true;
+
+    FrameQueries& frame = m_frames[m_currentFrame];
+    if (section.openRecord < (int)frame.records.size()) {
+        GLuint query = NextQuery();
+        glQueryCounter(query, GL_TIMESTAMP);
+        frame.records[section.openRecord].end = query;
+        frame.lastQuery = query;
+    }
+}
+
+GLuint Profiler::NextQuery() {
+    FrameQueries& frame = m_frames[m_currentFrame];
+    if (frame.used == frame.pool.size()) {
+        GLuint query;
+        glGenQueries(1, &query);
+        frame.pool.push_back(query);
+    }
+    return frame.pool[frame.used++];
+}
+
+bool Profiler::Collect(FrameQueries& frame) {
+    // Queries complete in order, so the last one tells us about all.
+    GLint available = 0;
+    glGetQueryObjectiv(frame.lastQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    std::vector<double> gpuFrame(m_sections.size(), 0.0);
+    std::vector<bool> timed(m_sections.size(), false);
+    for (const GpuRecord& record : frame.records) {
+        // Sections still open when the frame ended have no end query.
+        if (record.end == 0)
+            continue;
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(record.begin, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(record.end, GL_QUERY_RESULT, &end);
+        gpuFrame[record.section] += (double)(end - begin) / 1.0e6;
+        timed[record.section] = true;
+    }
+    for (size_t i = 0; i < m_sections.size(); i++) {
+        if (timed[i])
+            m_sections[i].gpu.Add(gpuFrame[i]);
+    }
+    return true;
+}
+
+ProfileStats Profiler::GetStats(const std::string& name) const {
+    ProfileStats stats;
+    for (const Section& section : m_sections) {
+        if (section.name == name) {
+            stats.cpuAverage = section.cpu.Average();
+            stats.gpuAverage = section.gpu.Average();
+            stats.cpuLast = section.cpu.last;
+            stats.gpuLast = section.gpu.last;
+            stats.samples = section.cpu.count;
+            break;
+        }
+    }
+    return stats;
+}
+
+std::vector<std::string> Profiler::GetSectionNames() const {
+    std::vector<std::string> names;
+    for (const Section& section : m_sections)
+        names.push_back(section.name);
+    return names;
+}
+
+void Profiler::Report(std::ostream& out) const {
+    out << "[Profiler] Averages over the last " << WINDOW << " frames (ms)\n";
+    out << "    " << std::left << std::setw(24) << "Section"
+        << std::right << std::setw(10) << "CPU" << std::setw(10) << "GPU" << "\n";
+    for (const Section& section : m_sections) {
+        if (section.cpu.count == 0 && section.gpu.count == 0)
+            continue;
+        out << "    " << std::left << std::setw(24) << section.name
+            << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << section.cpu.Average()
+            << std::setw(10) << section.gpu.Average() << "\n";
+    }
+    out << std::defaultfloat;
+}
+
+void Profiler::MaybeReport() {
+    if (m_reportInterval <= 0.0)
+        return;
+    unsigned long long now = SDL_GetPerformanceCounter();
+    if (ticksToMilliseconds(now - m_lastReport) < m_reportInterval * 1000.0)
+        return;
+    m_lastReport = now;
+
+    Report(std::cout);
+
+    if (m_statFile.is_open()) {
+        double seconds = ticksToMilliseconds(now - m_startTime) / 1000.0;
+        for (const Section& section : m_sections) {
+            m_statFile << seconds << "," << section.name << ","
+                       << section.cpu.Average() << "," << section.gpu.Average() << ","
+                       << section.cpu.last << "," << section.gpu.last << ","
+                       << section.cpu.count << "\n";
+        }
+        m_statFile.flush();
+    }
+}
+
+void Profiler::RollingAverage::Add(double sample) {
+    if (count == WINDOW)
+        sum -= samples[next];
+    else
+        count++;
+    samples[next] = sample;
+    sum += sample;
+    next = (next + 1) % WINDOW;
+    last = sample;
+}
+
+ScopedTimer::ScopedTimer(int id) : m_id(id), m_active(Profiler::Get().IsEnabled()), m_traceStart(0) {
+    if (Trace::Get().IsEnabled())
+        m_traceStart = SDL_GetPerformanceCounter();
+    if (m_active)
+        Profiler::Get().BeginSection(m_id);
+}
+
+ScopedTimer::~ScopedTimer() {
+    Stop();
+}
+
+void ScopedTimer::Stop() {
+    if (m_active) {
+        Profiler::Get().EndSection(m_id);
+        m_active = false;
+    }
+    if (m_traceStart != 0) {
+        Trace::Get().Record(m_id, m_traceStart, SDL_GetPerformanceCounter());
+        m_traceStart = 0;
+    }
+}
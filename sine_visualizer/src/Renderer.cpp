@@ -1,4 +1,6 @@
 #include "Renderer.h"
+#include "Profiler.h"
+#include "UniformBuffer.h"
 
 // Sets the height and width of our renderer
 Renderer::Renderer(unsigned int w, unsigned int h) : m_screenWidth(w), m_screenHeight(h){
@@ -19,6 +21,8 @@ Renderer::~Renderer(){
 }
 
 void Renderer::Update(){
+    PROFILE_SCOPE("Renderer::Update");
+
     // Here we apply the projection matrix which creates perspective.
     // The first argument is 'field of view'
     // Then perspective
@@ -37,63 +41,54 @@ void Renderer::Update(){
 // Setup our OpenGL State machine
 // Then render the scene
 void Renderer::Render(){
-    // Setup our uniforms
-    // In reality, only need to do this once for this
-    // particular fbo because the texture data is 
-    // not going to change.
-    myFramebuffer->Update();
-    // Bind to our farmebuffer
-    myFramebuffer->Bind();
-
-    // What we are doing, is telling opengl to create a depth(or Z-buffer) 
-    // for us that is stored every frame.
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_TEXTURE_2D); 
-    // This is the background of the screen.
-    glViewport(0, 0, m_screenWidth, m_screenHeight);
-    glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
-    // Clear color buffer and Depth Buffer
-    // Remember that the 'depth buffer' is our
-    // z-buffer that figures out how far away items are every frame
-    // and we have to do this every frame!
-    glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
-
-    // Use glPolygonMode() to enable and disable wireframe mode.
-    // GL_LINE will be used when wireframe is true, otherwise,
-    // GL_FILL will be used. This value is toggled with the
-    // 'w' key.
-    glPolygonMode(GL_FRONT_AND_BACK, (m_geometryWireframe) ? GL_LINE : GL_FILL);
+    // The scene pass renders everything into our framebuffer
+    {
+        PROFILE_SCOPE("ScenePass");
+        // Bind to our farmebuffer
+        myFramebuffer->Bind();
+
+        // What we are doing, is telling opengl to create a depth(or Z-buffer) 
+        // for us that is stored every frame.
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_TEXTURE_2D); 
+        // This is the background of the screen.
+        glViewport(0, 0, m_screenWidth, m_screenHeight);
+        glClearColor(0.01f, 0.01f, 0.01f, 1.0f);
+        // Clear color buffer and Depth Buffer
+        // Remember that the 'depth buffer' is our
+        // z-buffer that figures out how far away items are every frame
+        // and we have to do this every frame!
+        glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+        // Use glPolygonMode() to enable and disable wireframe mode.
+        // GL_LINE will be used when wireframe is true, otherwise,
+        // GL_FILL will be used. This value is toggled with the
+        // 'w' key.
+        glPolygonMode(GL_FRONT_AND_BACK, (m_geometryWireframe) ? GL_LINE : GL_FILL);
     
-    // Now we render our objects from our scenegraph
-    if(root!=nullptr){
-        root->Draw();
-    }
+        // Now we render our objects from our scenegraph
+        if(root!=nullptr){
+            root->Draw();
+        }
+        // The uniform ring can reuse the slots these draws read once
+        // the GPU passes this point.
+        UniformBuffer::Get().EndFrame();
 
-    // Finish with our framebuffer
-    myFramebuffer->Unbind();
+        // Finish with our framebuffer
+        myFramebuffer->Unbind();
+    }
 
-    // The framebuffer wireframe mode can be toggled using the
-    // 'e' key.
-    glPolygonMode(GL_FRONT_AND_BACK, (m_framebufferWireframe) ? GL_LINE : GL_FILL);
+    // The post-processing pass draws our framebuffer to the screen
+    PROFILE_SCOPE("PostProcess");
 
     // Now draw a new scene
     // We do not need depth since we are drawing a '2D'
     // image over our screen.
     glDisable(GL_DEPTH_TEST);
-    // Clear everything away
-    // Clear the screen color, and typically I do this
-    // to something 'different' than our original as an
-    // indication that I am in a FBO. But you may choose
-    // to match the glClearColor
-    glClearColor(1.0f,1.0f,1.0f,1.0f);
-    // We only have 'color' in our buffer that is stored
-    glClear(GL_COLOR_BUFFER_BIT); 
-    // Use our new 'simple screen shader'
-    myFramebuffer->fboShader->Bind();
-    // Overlay our 'quad' over the screen
-    myFramebuffer->drawFBO();    
-    // Unselect our shader and continue
-    myFramebuffer->fboShader->Unbind();
+    // Run every post-processing pass, overlaying the last 'quad'
+    // over the screen. The framebuffer wireframe mode can be
+    // toggled using the 'e' key.
+    myFramebuffer->drawPasses(m_framebufferWireframe);
 }
 
 // Determines what the root is of the renderer, so the
@@ -103,9 +98,12 @@ void Renderer::setRoot(SceneNode* n){
 }
 
 void Renderer::setFBOShader(std::string fboFragShader) {
-    // Delete and create a new framebuffer
-    delete myFramebuffer;
-    // Pass in fboFragShader to apply it to the new shader
-    myFramebuffer = new Framebuffer(fboFragShader);
-    myFramebuffer->Create(m_screenWidth, m_screenHeight);
+    // Every effect was compiled with the framebuffer, so only the
+    // program drawing the screen quad changes.
+    myFramebuffer->setEffect(fboFragShader);
+}
+
+void Renderer::addFBOShader(std::string fboFragShader) {
+    // Runs after every effect already in the chain
+    myFramebuffer->addPass(fboFragShader);
 }
@@ -14,13 +14,30 @@ SDLGraphicsProgram::SDLGraphicsProgram(int w, int h, std::string texture_filepat
     init();
 }
 
+// Every setting comes from the command line
+SDLGraphicsProgram::SDLGraphicsProgram(const ProgramOptions& options) : m_options(options), m_simulation(options.simulationRate), m_clock(options.simulationRate), WINDOW_WIDTH(options.windowWidth), WINDOW_HEIGHT(options.windowHeight), m_texturePath(options.texturePath), m_terrainPath(options.terrainPath){
+    init();
+}
+
 
 // Proper shutdown of SDL and destroy initialized objects
 SDLGraphicsProgram::~SDLGraphicsProgram(){
+    if(!m_options.traceFile.empty()){
+        Trace::Get().WriteJSON(m_options.traceFile);
+    }
+
     if(renderer!=nullptr){
         delete renderer;
     }
 
+    // The context has to outlive every OpenGL object.
+    Profiler::Get().Shutdown();
+    UniformBuffer::Get().Shutdown();
+    ShaderCache::Get().Shutdown();
+    if(m_headlessContext!=nullptr){
+        delete m_headlessContext;
+    }
+
     //Destroy window
     SDL_DestroyWindow( gWindow );
     // Point gWindow to NULL to ensure it points to nothing.
@@ -37,17 +54,48 @@ void SDLGraphicsProgram::init() {
     std::stringstream errorStream;
     // The window we'll be rendering to
     gWindow = NULL;
+    m_headlessContext = nullptr;
+    renderer = nullptr;
+    m_terrain = nullptr;
+    m_terrainNode = nullptr;
+    // Worker threads that build the geometry on every core
+    ThreadPool::Get().SetThreadCount(m_options.buildThreads);
     // Render flag
-
+    bool tessellation = (m_options.gridMode == "tessellation");
+
+    // Headless mode replaces the window with an offscreen EGL surface.
+    // SDL is still used for timing, so no SDL subsystem is needed.
+    if(m_options.headless){
+        std::string error;
+        m_headlessContext = new HeadlessContext();
+        // Tessellation needs OpenGL 4.0. Without it the plane is drawn
+        // from a vertex buffer instead.
+        if(tessellation && !m_headlessContext->Create(WINDOW_WIDTH, WINDOW_HEIGHT, 4, 0, error)){
+            std::cout << "OpenGL 4.0 is not available (" << error << "), using the vertexBuffer grid mode\n";
+            tessellation = false;
+            m_options.gridMode = "vertexBuffer";
+            delete m_headlessContext;
+            m_headlessContext = new HeadlessContext();
+        }
+        if(!tessellation && !m_headlessContext->Create(WINDOW_WIDTH, WINDOW_HEIGHT, 3, 3, error)){
+            errorStream << "Headless context could not be created! " << error << "\n";
+            success = false;
+        }
+        // Initialize GLAD Library
+        else if(!gladLoadGLLoader((GLADloadproc)HeadlessContext::GetProcAddress)){
+            errorStream << "Failed to iniitalize GLAD and OpenGL\n";
+            success = false;
+        }
+    }
     // Initialize SDL
-    if(SDL_Init(SDL_INIT_VIDEO)< 0){
+    else if(SDL_Init(SDL_INIT_VIDEO)< 0){
         errorStream << "SDL could not initialize! SDL Error: " << SDL_GetError() << "\n";
         success = false;
     }
     else{
-    //Use OpenGL 3.3 core
-    SDL_GL_SetAttribute( SDL_GL_CONTEXT_MAJOR_VERSION, 3 );
-    SDL_GL_SetAttribute( SDL_GL_CONTEXT_MINOR_VERSION, 3 );
+    //Use OpenGL 3.3 core, or 4.0 core for tessellation
+    SDL_GL_SetAttribute( SDL_GL_CONTEXT_MAJOR_VERSION, tessellation ? 4 : 3 );
+    SDL_GL_SetAttribute( SDL_GL_CONTEXT_MINOR_VERSION, tessellation ? 0 : 3 );
     SDL_GL_SetAttribute( SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE );
     // We want to request a double buffer for smooth updating.
     SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
@@ -69,6 +117,14 @@ void SDLGraphicsProgram::init() {
 
         //Create an OpenGL Graphics Context
         gContext = SDL_GL_CreateContext( gWindow );
+        if( gContext == NULL && tessellation ){
+            std::cout << "OpenGL 4.0 is not available (" << SDL_GetError() << "), using the vertexBuffer grid mode\n";
+            tessellation = false;
+            m_options.gridMode = "vertexBuffer";
+            SDL_GL_SetAttribute( SDL_GL_CONTEXT_MAJOR_VERSION, 3 );
+            SDL_GL_SetAttribute( SDL_GL_CONTEXT_MINOR_VERSION, 3 );
+            gContext = SDL_GL_CreateContext( gWindow );
+        }
         if( gContext == NULL){
             errorStream << "OpenGL context could not be created! SDL Error: " << SDL_GetError() << "\n";
             success = false;
@@ -86,6 +142,8 @@ void SDLGraphicsProgram::init() {
         errorStream << "SDLGraphicsProgram::SDLGraphicsProgram - Failed to initialize!\n";
         std::string errors=errorStream.str();
         SDL_Log("%s\n",errors.c_str());
+        // Nothing can be drawn without a context.
+        return;
     }else{
         SDL_Log("SDLGraphicsProgram::SDLGraphicsProgram - No SDL, GLAD, or OpenGL, errors detected during initialization\n\n");
     }
@@ -93,59 +151,187 @@ void SDLGraphicsProgram::init() {
     // SDL_LogSetAllPriority(SDL_LOG_PRIORITY_WARN); // Uncomment to enable extra debug support!
     getOpenGLVersionInfo();
 
+    // A 4.0 context was asked for, but the driver may still lack the
+    // tessellation functions.
+    if(tessellation && !GLAD_GL_VERSION_4_0){
+        std::cout << "OpenGL 4.0 functions are not available, using the vertexBuffer grid mode\n";
+        m_options.gridMode = "vertexBuffer";
+    }
+
+
+    // Programs are loaded from their saved binaries when they can be.
+    ShaderCache::Get().SetBinaryDirectory(m_options.shaderCacheDir);
 
     // Setup our Renderer
     renderer = new Renderer(WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    // Per pass timers are only recorded when asked for.
+    if(m_options.profile){
+        Profiler::Get().SetEnabled(true);
+        Profiler::Get().SetReportInterval(m_options.profileInterval);
+        if(!m_options.profileFile.empty())
+            Profiler::Get().SetStatFile(m_options.profileFile);
+    }
+    if(!m_options.traceFile.empty()){
+        Trace::Get().Start(m_options.traceCapacity);
+    }
+
+    applyPacing();
 }
 
-//Loops forever!
-void SDLGraphicsProgram::loop() {
+// Creates the terrain, its scene node, and places the camera.
+// Plane dimensions that were not passed in are prompted for.
+void SDLGraphicsProgram::setupScene() {
     // Get terrain data and build terrain
-    int terrainX;
-    int terrainZ;
+    int terrainX = m_options.terrainX;
+    int terrainZ = m_options.terrainZ;
+
+    if (terrainX <= 0 || terrainZ <= 0) {
+        std::cout << "Please enter the X and Z dimensions for your plane:\n\tX: ";
+        std::cin >> terrainX;
+        std::cout << "\tZ: ";
+        std::cin >> terrainZ;
+        std::cout << "\n\n";
+    }
 
-    std::cout << "Please enter the X and Z dimensions for your plane:\n\tX: ";
-    std::cin >> terrainX;
-    std::cout << "\tZ: ";
-    std::cin >> terrainZ;
-    std::cout << "\n\n";
+    buildScene(terrainX, terrainZ);
+}
 
+void SDLGraphicsProgram::buildScene(int terrainX, int terrainZ) {
     // Create terrain and assign texture if there is one
-    // The parser currently requires the X coordinate to
-    // be larger than the Z coordinate to properly add
-    // indices onto the geometry class.
-    Terrain* myTerrain = new Terrain(
-        (terrainX > terrainZ) ? terrainX : terrainZ, (terrainZ < terrainX) ? terrainZ : terrainX
-    );
+    GridMode gridMode = GridMode::VertexBuffer;
+    Terrain::ParseGridMode(m_options.gridMode, gridMode);
+    int tileSize = m_options.tileSize;
+    if (gridMode == GridMode::Lod)
+        tileSize = m_options.lodPatch;
+    else if (gridMode == GridMode::Tessellation)
+        tileSize = m_options.tessPatch;
+    else if (gridMode == GridMode::Instanced)
+        tileSize = m_options.instancePatch;
+    m_terrain = new Terrain(terrainX, terrainZ, gridMode, tileSize, m_options.vertexCache);
+    if (gridMode == GridMode::Lod)
+        m_terrain->setLodRange(m_options.lodRange);
+    if (gridMode == GridMode::Tessellation)
+        m_terrain->setTessellation(m_options.tessPixels, m_options.tessError);
+    if (gridMode == GridMode::Projected)
+        m_terrain->setProjectedCell(m_options.projectedCell);
 
     // Logic for adding a texture has not yet been fully implemented,
     // as it requires implementing a different vertex shader (more layouts).
     // It's a way to further expand the project.
     if (!m_texturePath.empty())
-        myTerrain->LoadTexture(m_texturePath);
-    // Create a node for the terrain 
-    SceneNode* terrainNode;
+        m_terrain->LoadTexture(m_texturePath);
     // The dimensions are also passed in to create light
     // offsets. This should be further abstracted in the
     // future, possibly by creating a light's class.
-    terrainNode = new SceneNode(
-        myTerrain,
-        (terrainX > terrainZ) ? terrainX : terrainZ, (terrainZ < terrainX) ? terrainZ : terrainX
-    );
+    LightingMode lighting = LightingMode::Tangent;
+    SceneNode::ParseLightingMode(m_options.lighting, lighting);
+    m_terrainNode = new SceneNode(m_terrain, terrainX, terrainZ, lighting);
     // Set up as root of SceneTree
-    renderer->setRoot(terrainNode);
+    renderer->setRoot(m_terrainNode);
+
+    m_terrainNode->setAmplitude(m_options.amplitude);
+    m_terrainNode->setWaveNumber(m_options.waveNumber);
+    m_terrainNode->setWavePeriod(m_options.wavePeriod);
+
+    // Automatically place height of the camera
+    m_cameraHeight = (terrainX > terrainZ) ? terrainX * 1.5f : terrainZ * 1.5f;
+
+    renderer->camera->setView(
+        // Eye position
+        glm::vec3(0.0f, m_cameraHeight, 0.0f),
+        // View direction
+        glm::vec3(0.0f,  -1.0f, 0.0f),
+        // Up vector
+        glm::vec3(0.0f,   0.0f, -1.0f));
+
+    m_terrain->setRenderMode(m_options.renderMode);
+    if (m_options.renderMode == "points")
+        std::cout << "Rendering in GL_POINTS mode.\n";
+    else
+        std::cout << "Rendering in GL_TRIANGLE_STRIP mode.\n";
+    m_terrainNode->setPlaneMode(m_options.planeMode);
+
+    if (fboFragShader.empty() && (m_options.effects.size() > 1 || m_options.effects[0] != "standard")) {
+        for (size_t i = 0; i < m_options.effects.size(); i++) {
+            fboFragShader = Framebuffer::EffectShader(m_options.effects[i]);
+            if (i == 0)
+                renderer->setFBOShader(fboFragShader);
+            else
+                renderer->addFBOShader(fboFragShader);
+        }
+    }
+}
+
+// The SceneNode does not own its object, so both are deleted here.
+void SDLGraphicsProgram::destroyScene() {
+    renderer->setRoot(nullptr);
+    delete m_terrainNode;
+    delete m_terrain;
+    m_terrainNode = nullptr;
+    m_terrain = nullptr;
+}
+
+void SDLGraphicsProgram::swapBuffers() {
+    PROFILE_SCOPE("SwapBuffers");
+    if (m_headlessContext != nullptr)
+        m_headlessContext->SwapBuffers();
+    else
+        SDL_GL_SwapWindow(getSDLWindow());
+}
+
+void SDLGraphicsProgram::applyPacing() {
+    PacingMode mode = (m_headlessContext != nullptr) ? PacingMode::Unlimited : PacingMode::VSync;
+    if (!m_options.pacing.empty())
+        FramePacer::ParseMode(m_options.pacing, mode);
+    // Under vsync a frame is due every refresh, whatever targetFPS is.
+    double refreshRate = 0.0;
+    SDL_DisplayMode displayMode;
+    if (m_headlessContext == nullptr && SDL_GetWindowDisplayMode(getSDLWindow(), &displayMode) == 0)
+        refreshRate = displayMode.refresh_rate;
+    m_pacer.Configure(mode, m_options.targetFPS, refreshRate);
+
+    int interval = m_pacer.GetSwapInterval();
+    if (m_headlessContext != nullptr) {
+        // A pbuffer is never displayed, so there is nothing to sync to.
+        m_headlessContext->SetSwapInterval(0);
+    } else if (SDL_GL_SetSwapInterval(interval) != 0 && interval == -1) {
+        std::cout << "Adaptive vsync is not supported, using vsync.\n";
+        m_pacer.FallBackToVSync();
+        SDL_GL_SetSwapInterval(1);
+    }
+    std::cout << "Frame pacing: " << FramePacer::ModeName(m_pacer.GetMode()) << "\n";
+}
+
+void SDLGraphicsProgram::stepSimulation(double seconds) {
+    int steps = m_simulation.Advance(seconds);
+    double step = m_clock.GetStepSeconds();
+    for (int i = 0; i < steps; i++) {
+        m_clock.Step();
+        m_terrainNode->Advance(step);
+    }
+    m_terrainNode->setTimeOffset(m_simulation.GetAlpha() * step);
+}
+
+//Loops forever!
+void SDLGraphicsProgram::loop() {
+    if (renderer == nullptr)
+        return;
 
-    float amplitude = 100.0f;
+    setupScene();
+
+    Terrain* myTerrain = m_terrain;
+    SceneNode* terrainNode = m_terrainNode;
+    float cameraHeight = m_cameraHeight;
+
+    float amplitude = m_options.amplitude;
     float amplitudeSpeed = 1.0f;
-    terrainNode->setAmplitude(amplitude);
 
-    float waveNumber = 0.5f;
+    float waveNumber = m_options.waveNumber;
     float waveNumberSpeed = 0.1;
-    terrainNode->setWaveNumber(waveNumber);
 
-    float wavePeriod = 50.0f;
+    float wavePeriod = m_options.wavePeriod;
     float wavePeriodSpeed = 5.0f;
-    terrainNode->setWavePeriod(wavePeriod);
 
     // Flag to keep track of whether wireframe mode is enabled
     bool geometryWireframe = false;
@@ -159,21 +345,6 @@ void SDLGraphicsProgram::loop() {
     // Set a default speed for the camera
     float cameraSpeed = 5.0f;
 
-    // Automatically place height of the camera
-    float cameraHeight = (terrainX > terrainZ) ? terrainX * 1.5f : terrainZ * 1.5f;
-
-    renderer->camera->setView(
-        // Eye position
-        glm::vec3(0.0f, cameraHeight, 0.0f),
-        // View direction
-        glm::vec3(0.0f,  -1.0f, 0.0f),
-        // Up vector
-        glm::vec3(0.0f,   0.0f, -1.0f));
-
-    myTerrain->setRenderMode("triStrip");
-    std::cout << "Rendering in GL_TRIANGLE_STRIP mode.\n";
-    terrainNode->setPlaneMode("yAxis");
-
     // Event handler that handles various events in SDL
     // that are related to input and output
     SDL_Event e;
@@ -186,9 +357,13 @@ void SDLGraphicsProgram::loop() {
 
     // While application is running
     while(!quit){
+        m_pacer.BeginFrame();
+        Profiler::Get().BeginFrame();
         terrainNode->getLocalTransform().loadIdentity();
 
         //Handle events on queue
+        static const int pollSection = Profiler::Get().GetSectionID("EventPolling");
+        ScopedTimer pollTimer(pollSection);
         while(SDL_PollEvent(&e) != 0){
             // User posts an event to quit
             // An example is hitting the "x" in the corner of the window.
@@ -283,6 +458,24 @@ void SDLGraphicsProgram::loop() {
                             renderer->camera->moveDown(cameraSpeed);
                             break;
 
+                        // Use 'i' to print the per pass timings
+                        case SDLK_i:
+                            m_pacer.Report(std::cout);
+                            m_terrain->printCullStats(std::cout);
+                            if (Profiler::Get().IsEnabled())
+                                Profiler::Get().Report(std::cout);
+                            else
+                                std::cout << "Profiling is disabled. Run with --profile.\n";
+                            break;
+
+                        // Use 't' to write the latest frames of the timeline
+                        case SDLK_t:
+                            if (Trace::Get().IsEnabled())
+                                Trace::Get().WriteJSON(m_options.traceFile);
+                            else
+                                std::cout << "The timeline is disabled. Run with --trace FILE.\n";
+                            break;
+
                         // Use 'r' to allow the mouse to move the camera sideways
                         case SDLK_r:
                             camRotationEnabled = !camRotationEnabled;
@@ -336,6 +529,30 @@ void SDLGraphicsProgram::loop() {
                         case SDLK_c:
                             terrainNode->setPlaneMode("flat");
                             break;
+                        // - halves and = doubles the plane, in the grid modes
+                        // that can be resized without rebuilding buffers
+                        case SDLK_MINUS:
+                        case SDLK_EQUALS:
+                            {
+                                int x = m_terrain->getXSegments();
+                                int z = m_terrain->getZSegments();
+                                if (e.key.keysym.sym == SDLK_MINUS) {
+                                    x = std::max(2, x / 2);
+                                    z = std::max(2, z / 2);
+                                } else {
+                                    x = std::min(Terrain::MAX_SEGMENTS, x * 2);
+                                    z = std::min(Terrain::MAX_SEGMENTS, z * 2);
+                                }
+                                if (x == m_terrain->getXSegments() && z == m_terrain->getZSegments()) {
+                                    std::cout << "Plane: " << x << "x" << z << " is already the " << (e.key.keysym.sym == SDLK_MINUS ? "smallest" : "largest") << " size.\n";
+                                } else if (m_terrain->resize(x, z)) {
+                                    terrainNode->setPlaneSize(x, z);
+                                    std::cout << "Plane: " << x << "x" << z << '\n';
+                                } else {
+                                    std::cout << "Only the procedural, projected and instanced grids can be resized.\n";
+                                }
+                            }
+                            break;
 
 //===================== RENDER MODES
                         // Use the w key to toggle wireframe mode
@@ -369,29 +586,21 @@ void SDLGraphicsProgram::loop() {
 
 //===================== POST-PROCESSING EFFECTS
                         case SDLK_1:
-                            fboFragShader = "./shaders/fboFrag_standard.glsl";
-                            renderer->setFBOShader(fboFragShader);
-                            break;
                         case SDLK_2:
-                            fboFragShader = "./shaders/fboFrag_grayscale.glsl";
-                            renderer->setFBOShader(fboFragShader);
-                            break;
                         case SDLK_3:
-                            fboFragShader = "./shaders/fboFrag_blur.glsl";
-                            renderer->setFBOShader(fboFragShader);
-                            break;
                         case SDLK_4:
-                            fboFragShader = "./shaders/fboFrag_invertColors.glsl";
-                            renderer->setFBOShader(fboFragShader);
-                            break;
                         case SDLK_5:
-                            fboFragShader = "./shaders/fboFrag_sharpen.glsl";
-                            renderer->setFBOShader(fboFragShader);
-                            break;
-                        case SDLK_6:
-                            fboFragShader = "./shaders/fboFrag_edgeDetection.glsl";
-                            renderer->setFBOShader(fboFragShader);
+                        case SDLK_6: {
+                            fboFragShader = Framebuffer::EffectShader(Framebuffer::EFFECT_NAMES[e.key.keysym.sym - SDLK_1]);
+                            // Shift adds the effect to the end of the
+                            // chain instead of replacing the chain.
+                            if (e.key.keysym.mod & KMOD_SHIFT)
+                                renderer->addFBOShader(fboFragShader);
+                            else
+                                renderer->setFBOShader(fboFragShader);
+                            std::cout << "Post-processing passes: " << renderer->myFramebuffer->getPassCount() << "\n";
                             break;
+                        }
 
                         default:
                             break;
@@ -399,22 +608,209 @@ void SDLGraphicsProgram::loop() {
                 break;
             }
         } // End SDL_PollEvent loop.
+        pollTimer.Stop();
 
+        // Advance the waves by the real time that passed
+        stepSimulation(m_pacer.GetDeltaSeconds());
         // Update our scene through our renderer
         renderer->Update();
         // Render our scene using our selected renderer
         renderer->Render();
-        // Delay to slow things down just a bit!
-        SDL_Delay(25); 
+        // Wait for the next frame in target frame rate mode
+        {
+            PROFILE_SCOPE("FramePacing");
+            m_pacer.Wait();
+        }
         //Update screen of our specified window
-        SDL_GL_SwapWindow(getSDLWindow());
+        swapBuffers();
+        Profiler::Get().EndFrame();
     }
 
+    m_pacer.Report(std::cout);
+
     //Disable text input
     SDL_StopTextInput();
 }
 
 
+// Renders the requested number of frames offscreen, then returns
+// so the program can exit. No input is read at any point.
+bool SDLGraphicsProgram::runHeadless() {
+    if (renderer == nullptr || m_headlessContext == nullptr)
+        return false;
+
+    setupScene();
+
+    renderer->setGeometryWireframe(false);
+    renderer->setFramebufferWireframe(false);
+
+    std::cout << "Rendering " << m_options.frames << " headless frame(s) at "
+              << WINDOW_WIDTH << "x" << WINDOW_HEIGHT << ".\n";
+
+    for (int frame = 0; frame < m_options.frames; frame++) {
+        m_pacer.BeginFrame();
+        Profiler::Get().BeginFrame();
+        m_terrainNode->getLocalTransform().loadIdentity();
+        // Every frame advances by exactly one frame period, so the
+        // output does not depend on how fast frames are rendered.
+        stepSimulation(1.0 / m_options.targetFPS);
+        renderer->Update();
+        renderer->Render();
+        m_pacer.Wait();
+        swapBuffers();
+        Profiler::Get().EndFrame();
+    }
+    // Make sure every frame actually finished on the GPU.
+    glFinish();
+
+    if (m_pacer.GetMode() != PacingMode::Unlimited)
+        m_pacer.Report(std::cout);
+    m_terrain->printCullStats(std::cout);
+    if (Profiler::Get().IsEnabled())
+        Profiler::Get().Report(std::cout);
+
+    if (!m_options.outputPath.empty())
+        saveFrame(m_options.outputPath);
+
+    return true;
+}
+
+// Renders a fixed camera path over a square plane of each requested
+// size with no delay and no vsync, so the numbers only depend on
+// the cost of a frame.
+bool SDLGraphicsProgram::runBenchmark() {
+    if (renderer == nullptr)
+        return false;
+
+    // Do not wait for the display between frames.
+    if (m_headlessContext != nullptr)
+        m_headlessContext->SetSwapInterval(0);
+    else
+        SDL_GL_SetSwapInterval(0);
+
+    renderer->setGeometryWireframe(false);
+    renderer->setFramebufferWireframe(false);
+
+    Benchmark benchmark;
+    std::vector<BenchmarkResult> results;
+    const int totalFrames = m_options.benchWarmup + m_options.benchFrames;
+
+    // Every grid and lighting mode runs the same sizes on the same
+    // camera path.
+    std::vector<std::string> grids = m_options.benchGrids;
+    if (grids.empty())
+        grids.push_back(m_options.gridMode);
+    std::vector<std::string> lightings = m_options.benchLighting;
+    if (lightings.empty())
+        lightings.push_back(m_options.lighting);
+    const std::string gridMode = m_options.gridMode;
+    const std::string lightingMode = m_options.lighting;
+
+    const size_t sizes = m_options.benchSizes.size();
+    const size_t modes = grids.size() * lightings.size();
+    for (size_t run = 0; run < modes * sizes; run++) {
+        const std::string& grid = grids[run / sizes / lightings.size()];
+        const std::string& lighting = lightings[run / sizes % lightings.size()];
+        int size = m_options.benchSizes[run % sizes];
+        // Tessellation needs the 4.0 context asked for at start up.
+        if (grid == "tessellation" && gridMode != "tessellation") {
+            if (run % (sizes * lightings.size()) == 0)
+                std::cout << "\n[Benchmark] Skipping tessellation, which needs --grid tessellation.\n";
+            continue;
+        }
+        m_options.gridMode = grid;
+        m_options.lighting = lighting;
+        std::cout << "\n[Benchmark] Building " << size << "x" << size << " plane (" << grid << ", " << lighting << " lighting).\n";
+        buildScene(size, size);
+
+        glm::vec3 eye, viewDir;
+        for (int frame = 0; frame < totalFrames; frame++) {
+            bool measured = frame >= m_options.benchWarmup;
+            // Quit early if the window is closed.
+            SDL_Event e;
+            while (SDL_PollEvent(&e) != 0) {
+                if (e.type == SDL_QUIT) {
+                    destroyScene();
+                    m_options.gridMode = gridMode;
+                    m_options.lighting = lightingMode;
+                    return false;
+                }
+            }
+
+            // Counted after the warmup, since LOD grids draw a
+            // different number of triangles every frame.
+            if (frame == m_options.benchWarmup)
+                benchmark.BeginRun(size, size, m_terrain->getTriangleCount(), m_options.benchFrames);
+
+            Benchmark::CameraPath(frame, totalFrames, m_cameraHeight, eye, viewDir);
+            renderer->camera->setView(eye, viewDir, glm::vec3(0.0f, 1.0f, 0.0f), false);
+
+            Profiler::Get().BeginFrame();
+            if (measured)
+                benchmark.BeginFrame();
+            m_terrainNode->getLocalTransform().loadIdentity();
+            stepSimulation(1.0 / m_options.targetFPS);
+            renderer->Update();
+            renderer->Render();
+            swapBuffers();
+            if (measured)
+                benchmark.EndFrame();
+            Profiler::Get().EndFrame();
+        }
+
+        BenchmarkResult result = benchmark.EndRun();
+        result.grid = grid;
+        result.lighting = lighting;
+        result.bufferBytes = m_terrain->getBufferBytes();
+        Benchmark::Print(result);
+        m_terrain->printCullStats(std::cout);
+        results.push_back(result);
+
+        destroyScene();
+    }
+    m_options.gridMode = gridMode;
+    m_options.lighting = lightingMode;
+    if (modes > 1)
+        Benchmark::PrintComparison(results);
+    // Every program the runs used, built as on a first start and as
+    // on the next one.
+    ShaderCache::Get().StartupReport(std::cout);
+
+    std::string vendor = (const char*)glGetString(GL_VENDOR);
+    std::string rendererName = (const char*)glGetString(GL_RENDERER);
+    if (!m_options.benchJSON.empty())
+        Benchmark::WriteJSON(m_options.benchJSON, results, WINDOW_WIDTH, WINDOW_HEIGHT, vendor, rendererName);
+    if (!m_options.benchCSV.empty())
+        Benchmark::WriteCSV(m_options.benchCSV, results);
+
+    return true;
+}
+
+// Writes the default framebuffer as a PPM image, in the same format
+// Image::loadPPM() reads (one value per line).
+void SDLGraphicsProgram::saveFrame(const std::string& filepath) {
+    std::vector<unsigned char> pixels(WINDOW_WIDTH * WINDOW_HEIGHT * 3);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+    std::ofstream ppmFile(filepath.c_str());
+    if (!ppmFile.is_open()) {
+        std::cout << "ERROR - Unable to write ppm file: " << filepath << "\n";
+        return;
+    }
+    ppmFile << "P3\n" << WINDOW_WIDTH << " " << WINDOW_HEIGHT << "\n255\n";
+    // OpenGL stores rows bottom to top.
+    for (int y = WINDOW_HEIGHT - 1; y >= 0; y--) {
+        for (int x = 0; x < WINDOW_WIDTH * 3; x++) {
+            ppmFile << (int)pixels[y * WINDOW_WIDTH * 3 + x] << "\n";
+        }
+    }
+    ppmFile.close();
+    std::cout << "Saved frame to " << filepath << "\n";
+}
+
+
 // Get Pointer to Window
 SDL_Window* SDLGraphicsProgram::getSDLWindow(){
   return gWindow;
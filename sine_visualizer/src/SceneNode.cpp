@@ -1,12 +1,28 @@
 #include "SceneNode.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "UniformBuffer.h"
+
+#include <cmath>
+
+#include "glm/glm.hpp"
+
+// Converts a color in HSV to RGB, the same way frag.glsl used to for
+// every fragment.
+// REF: https://gamedev.stackexchange.com/questions/59797/glsl-shader-change-hue-saturation-brightness
+static glm::vec3 HSVtoRGB(glm::vec3 color) {
+	glm::vec4 K = glm::vec4(1.0f, 2.0f / 3.0f, 1.0f / 3.0f, 3.0f);
+	glm::vec3 p = glm::abs(glm::fract(glm::vec3(color.x) + glm::vec3(K)) * 6.0f - glm::vec3(K.w));
+	return color.z * glm::mix(glm::vec3(K.x), glm::clamp(p - glm::vec3(K.x), 0.0f, 1.0f), color.y);
+}
 
 // The constructor
-SceneNode::SceneNode(Object* ob) : object(ob) {
+SceneNode::SceneNode(Object* ob) : object(ob), m_lighting(LightingMode::Tangent), m_uniformSlot(0) {
 	init();      
 }
 
 // Used to set light offsets when creating a terrain
-SceneNode::SceneNode(Object* ob, int xSegs, int zSegs) : object(ob), m_xSegments(xSegs), m_zSegments(zSegs) {
+SceneNode::SceneNode(Object* ob, int xSegs, int zSegs, LightingMode lighting) : object(ob), m_xSegments(xSegs), m_zSegments(zSegs), m_lighting(lighting), m_uniformSlot(0) {
 	init();      
 }
 
@@ -22,9 +38,7 @@ void SceneNode::init() {
 	std::cout << "(SceneNode.cpp) Constructor Called\n";
 
 	// Initialize timer settings
-	m_currentTime = SDL_GetPerformanceCounter();
-	m_previousTime = 0.0f;
-	m_elapsedTime = 0.0f;
+	m_timeOffset = 0.0;
 
 	// By default, we do not know the parent
 	// at the time of construction of this node.
@@ -32,11 +46,27 @@ void SceneNode::init() {
 	// then there is no parent.
 	parent = nullptr;
 	
-	// Setup shaders for the node.
-	std::string vertexShader = myShader.LoadShader("./shaders/vert.glsl");
-	std::string fragmentShader = myShader.LoadShader("./shaders/frag.glsl");
-	// Actually create our shader
-	myShader.CreateShader(vertexShader, fragmentShader); 
+	// Setup shaders for the node. Every plane mode gets its own
+	// variant, so switching between them never rebuilds a program.
+	ShaderFiles files;
+	files.fragment = "./shaders/frag.glsl";
+	// Objects drawn as patches apply the wave after tessellation.
+	if(object != nullptr && object->usesTessellation()){
+		files.vertex = "./shaders/tessVert.glsl";
+		files.tessControl = "./shaders/tessCtrl.glsl";
+		files.tessEvaluation = "./shaders/tessEval.glsl";
+	} else {
+		files.vertex = "./shaders/vert.glsl";
+	}
+	ShaderDefines defines;
+	defines["NR_POINT_LIGHTS"] = std::to_string(NUMBER_OF_POINT_LIGHTS);
+	if(m_lighting == LightingMode::World)
+		defines["WORLD_LIGHTING"] = "";
+	for(int planeMode = 0; planeMode < 3; planeMode++){
+		defines["PLANE_MODE"] = std::to_string(planeMode);
+		m_planeModeShaders[planeMode] = ShaderCache::Get().GetProgram(files, defines);
+	}
+	myShader = m_planeModeShaders[2];
 }
 // Adds a child node to our current node.
 void SceneNode::AddChild(SceneNode* n){
@@ -54,10 +84,13 @@ void SceneNode::AddChild(SceneNode* n){
 // object and all of its children. This is done by calling directly
 // the objects draw method.
 void SceneNode::Draw(){
-	myShader.Bind();
+	PROFILE_SCOPE("SceneNode::Draw");
+	myShader->Bind();
+	// The blocks Update() wrote for this node
+	UniformBuffer::Get().Bind(m_uniformSlot);
 	if(object!=nullptr){
 		object->render();
-		for(int i = 0; i < children.size(); ++i){
+		for(size_t i = 0; i < children.size(); ++i){
 			children[i]->Draw();
 		}
 	}	
@@ -68,14 +101,8 @@ void SceneNode::Draw(){
 // the objects update method.
 // TODO: Consider not passting projection and camera here
 void SceneNode::Update(glm::mat4 projectionMatrix, Camera* camera) {
+	PROFILE_SCOPE("SceneNode::Update");
     if (object != nullptr) {
-		m_previousTime = m_currentTime;
-		m_currentTime = SDL_GetPerformanceCounter();
-		// * 1000 converts milliseconds into seconds
-		float deltaTime = (m_currentTime - m_previousTime) * 1000 / SDL_GetPerformanceFrequency();
-
-		m_elapsedTime += deltaTime;
-
 		int planeMode_ID;
 
 		if (m_planeMode == "flat") {
@@ -87,117 +114,120 @@ void SceneNode::Update(glm::mat4 projectionMatrix, Camera* camera) {
 		}
 
     	// Apply our shader transformation
+		myShader = m_planeModeShaders[planeMode_ID];
+		myShader->Bind();
+		// Anything specific to the object, such as the grid layout
+		object->setUniforms(*myShader);
+		// The wave moves vertices at most |amplitude| off the plane.
+		glm::mat4 model = worldTransform.getInternalMatrix();
+		glm::vec4 eye = glm::inverse(model) * glm::vec4(camera->getEyeXPosition(),
+														 camera->getEyeYPosition(),
+														 camera->getEyeZPosition(), 1.0f);
+		glm::mat4 view = camera->getWorldToViewmatrix();
+		glm::mat4 modelViewProjection = projectionMatrix * view * model;
+		object->cull(modelViewProjection, glm::vec3(eye),
+					 (planeMode_ID == 0) ? 0.0f : std::fabs(m_amplitude));
+
+		// The camera and the directional light, which circles around
+		// the plane.
+		FrameBlock frame;
+		frame.view = view;
+		frame.projection = projectionMatrix;
+		frame.viewPos = glm::vec4(camera->getEyeXPosition(),
+								  camera->getEyeYPosition(),
+								  camera->getEyeZPosition(), 1.0f);
+		float lightPhase = (float)m_animation.light.Sample(WaveAnimation::LIGHT_VELOCITY, m_timeOffset);
+		frame.lightDirection = glm::vec4(std::sin(lightPhase), 5.0f, std::cos(lightPhase), 0.0f);
+
+		// Derived values that are the same for every vertex or fragment
+		// of the frame are computed once here, instead of by the shaders
+		// for each one.
+		ObjectBlock block = {};
+		block.model = model;
+		block.modelViewProjection = modelViewProjection;
+		glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+		for (int i = 0; i < 3; i++)
+			block.normalMatrix[i] = glm::vec4(normalMatrix[i], 0.0f);
+		// The hue and saturation of the plane cycle over time.
+		float huePhase = (float)m_animation.hue.Sample(WaveAnimation::HUE_VELOCITY, m_timeOffset);
+		float saturationPhase = (float)m_animation.saturation.Sample(WaveAnimation::SATURATION_VELOCITY, m_timeOffset);
+		block.diffuseColor = HSVtoRGB(glm::vec3(std::tan(huePhase), (std::cos(saturationPhase) + 1.0f) / 2.0f, 1.0f)) * 0.7f;
+		block.amplitude = m_amplitude;
+		block.waveNumber = m_waveNumber;
+		block.wavePeriod = m_wavePeriod;
+		// Only wrapped phases are sent, never the elapsed time.
+		block.wavePhase = (float)m_animation.wave.Sample(waveVelocity(), m_timeOffset);
+		block.materialShininess = 32.0f;
+
+		// The lights only change with the size of the plane, so they
+		// are only uploaded then.
+		LightsBlock lights = {};
+		lights.dirLight.color = glm::vec3(1.0f, 1.0f, 1.0f);
+		lights.dirLight.ambientIntensity = 0.1f;
+		lights.dirLight.specularStrength = 0.3f;
 
-		myShader.Bind();
-    	// Set the uniforms in our current shader
-
-		myShader.setUniform1i("planeMode", planeMode_ID);
-
-        // For our object, we apply the texture in the following way
-        // Note that we set the value to 0, because we have bound
-        // our texture to slot 0.
-        // myShader.setUniform1i("material.u_diffuse", 0);
-		myShader.setUniform1f("material_shininess", 32.0f);
-
-		myShader.setUniform1f("amplitude", m_amplitude);
-		myShader.setUniform1f("waveNumber", m_waveNumber);
-		myShader.setUniform1f("wavePeriod", m_wavePeriod);
-		
-		myShader.setUniform1f("time", m_elapsedTime / 60.0f);
-
-
-        // Set the MVP Matrix for our object
-        // Send it into our shader
-        myShader.setUniformMatrix4fv("model", &worldTransform.getInternalMatrix()[0][0]);
-        myShader.setUniformMatrix4fv("view", &camera->getWorldToViewmatrix()[0][0]);
-        myShader.setUniformMatrix4fv("projection", &projectionMatrix[0][0]);
-
-		myShader.setUniform3f("viewPos",
-							  camera->getEyeXPosition(),
-							  camera->getEyeYPosition(),
-							  camera->getEyeZPosition());
-
-        // Create a directional light
-        myShader.setUniform3f("dirLight.direction", 0.0f, 5.0f, 0.0f);
-        myShader.setUniform3f("dirLight.color", 1.0f, 1.0f, 1.0f);
-        myShader.setUniform1f("dirLight.ambientIntensity", 0.1f);
-		myShader.setUniform1f("dirLight.specularStrength", 0.3f);
-
-		// Set point lights attributes
-		const int numLights = 13;
 		const float pointLightsOffsetX = (m_xSegments / 2) * 0.8f;
 		const float pointLightsOffsetZ = (m_zSegments / 2) * 0.8f;
 		const float pointLightsHeight = 5.0f;
-		const glm::vec3 pointLightsColor = glm::vec3(1.0f);
-		const float pointLightsIntensity = 8.0f;
-		const float pointLightsSpecularStrength = 0.2f;
-		const float constant = 1.0f;
-		const float linear = 0.09f;
-		const float quadratic = 0.032f;
-
-		// Set point light positions
-		myShader.setUniform3f("pointLights[0].position",
-			0.0f, pointLightsHeight, 0.0f);
-		myShader.setUniform3f("pointLights[1].position",
-			-pointLightsOffsetX, pointLightsHeight, -pointLightsOffsetZ);
-		myShader.setUniform3f("pointLights[2].position",
-			-pointLightsOffsetX, pointLightsHeight, pointLightsOffsetZ);
-		myShader.setUniform3f("pointLights[3].position",
-			pointLightsOffsetX, pointLightsHeight, -pointLightsOffsetZ);
-		myShader.setUniform3f("pointLights[4].position",
-			pointLightsOffsetX, pointLightsHeight, pointLightsOffsetZ);
-		myShader.setUniform3f("pointLights[5].position",
-			-pointLightsOffsetX / 1.75f, pointLightsHeight, -pointLightsOffsetZ / 1.75f);
-		myShader.setUniform3f("pointLights[6].position",
-			-pointLightsOffsetX / 1.75f, pointLightsHeight, pointLightsOffsetZ / 1.75f);
-		myShader.setUniform3f("pointLights[7].position",
-			pointLightsOffsetX / 1.75f, pointLightsHeight, -pointLightsOffsetZ / 1.75f);
-		myShader.setUniform3f("pointLights[8].position",
-			pointLightsOffsetX / 1.75f, pointLightsHeight, pointLightsOffsetZ / 1.75f);
-		myShader.setUniform3f("pointLights[9].position",
-			-pointLightsOffsetX / 1.25f, pointLightsHeight, 0.0f);
-		myShader.setUniform3f("pointLights[10].position",
-			pointLightsOffsetX / 1.25f,
-			pointLightsHeight, 0.0f);
-		myShader.setUniform3f("pointLights[11].position",
-			0.0f, pointLightsHeight, -pointLightsOffsetZ / 1.25f);
-		myShader.setUniform3f("pointLights[12].position",
-			0.0f, pointLightsHeight, pointLightsOffsetZ / 1.25f);
-
-		// Set other point light values
-		std::string tempString;
-		for (unsigned int i = 0; i < numLights; i++) {
-			// Color
-			tempString = "pointLights[" + std::to_string(i) + "].color";
-			myShader.setUniform3f(strToCharArray(tempString), pointLightsColor.x, pointLightsColor.y, pointLightsColor.z);
-
-			// Ambient Intensity
-			tempString = "pointLights[" + std::to_string(i) + "].ambientIntensity";
-			myShader.setUniform1f(strToCharArray(tempString), pointLightsIntensity);
-
-			// Specular Strength
-			tempString = "pointLights[" + std::to_string(i) + "].specularStrength";
-			myShader.setUniform1f(strToCharArray(tempString), pointLightsSpecularStrength);
-
-			// Constant
-			tempString = "pointLights[" + std::to_string(i) + "].constant";
-			myShader.setUniform1f(strToCharArray(tempString), constant);
-
-			// Linear
-			tempString = "pointLights[" + std::to_string(i) + "].linear";
-			myShader.setUniform1f(strToCharArray(tempString), linear);
-
-			// Quadratic
-			tempString = "pointLights[" + std::to_string(i) + "].quadratic";
-			myShader.setUniform1f(strToCharArray(tempString), quadratic);
+		const glm::vec3 pointLightsPositions[NUMBER_OF_POINT_LIGHTS] = {
+			glm::vec3(0.0f, pointLightsHeight, 0.0f),
+			glm::vec3(-pointLightsOffsetX, pointLightsHeight, -pointLightsOffsetZ),
+			glm::vec3(-pointLightsOffsetX, pointLightsHeight, pointLightsOffsetZ),
+			glm::vec3(pointLightsOffsetX, pointLightsHeight, -pointLightsOffsetZ),
+			glm::vec3(pointLightsOffsetX, pointLightsHeight, pointLightsOffsetZ),
+			glm::vec3(-pointLightsOffsetX / 1.75f, pointLightsHeight, -pointLightsOffsetZ / 1.75f),
+			glm::vec3(-pointLightsOffsetX / 1.75f, pointLightsHeight, pointLightsOffsetZ / 1.75f),
+			glm::vec3(pointLightsOffsetX / 1.75f, pointLightsHeight, -pointLightsOffsetZ / 1.75f),
+			glm::vec3(pointLightsOffsetX / 1.75f, pointLightsHeight, pointLightsOffsetZ / 1.75f),
+			glm::vec3(-pointLightsOffsetX / 1.25f, pointLightsHeight, 0.0f),
+			glm::vec3(pointLightsOffsetX / 1.25f, pointLightsHeight, 0.0f),
+			glm::vec3(0.0f, pointLightsHeight, -pointLightsOffsetZ / 1.25f),
+			glm::vec3(0.0f, pointLightsHeight, pointLightsOffsetZ / 1.25f)
+		};
+		for (int i = 0; i < NUMBER_OF_POINT_LIGHTS; i++) {
+			PointLightData& light = lights.pointLights[i];
+			light.position = pointLightsPositions[i];
+			light.color = glm::vec3(1.0f);
+			light.ambientIntensity = 8.0f;
+			light.specularStrength = 0.2f;
+			light.constant = 1.0f;
+			light.linear = 0.09f;
+			light.quadratic = 0.032f;
 		}
-		
-		for(int i =0; i < children.size(); ++i){
+
+		UniformBuffer::Get().SetLights(lights);
+		m_uniformSlot = UniformBuffer::Get().Write(frame, block);
+
+		for(size_t i =0; i < children.size(); ++i){
 			children[0]->Update(projectionMatrix, camera);
 		}
 	}
 }
 
+// Time only moves forward in fixed steps, which keeps the waves
+// independent of the frame rate.
+void SceneNode::Advance(double deltaTime) {
+	m_animation.Advance(waveVelocity(), deltaTime);
+	for(size_t i = 0; i < children.size(); ++i){
+		children[i]->Advance(deltaTime);
+	}
+}
+
+bool SceneNode::ParseLightingMode(const std::string& name, LightingMode& mode){
+	if (name == "tangent")
+		mode = LightingMode::Tangent;
+	else if (name == "world")
+		mode = LightingMode::World;
+	else
+		return false;
+	return true;
+}
+
+// Radians per second the wave travels at
+double SceneNode::waveVelocity() const {
+	return WaveAnimation::WaveVelocity(m_wavePeriod);
+}
+
 // Returns the actual local transform stored in our SceneNode
 // which can then be modified
 Transform& SceneNode::getLocalTransform(){
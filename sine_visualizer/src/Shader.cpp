@@ -1,7 +1,14 @@
 #include "Shader.h"
+#include "UniformBuffer.h"
+
+#include <cstring>
+
+// Every link gets a new generation, so handles from another shader or
+// an older link are never mistaken for current ones.
+static unsigned int nextGeneration = 1;
 
 // Constructor
-Shader::Shader(){
+Shader::Shader() : shaderID(0), m_generation(0){
 	std::cout << "(Shader.cpp) Constructor Called\n";
 }
 
@@ -49,6 +56,24 @@ std::string Shader::LoadShader(const std::string& fname){
 		return result;
 }
 
+std::string Shader::AddDefines(const std::string& source, const ShaderDefines& defines){
+    std::string lines;
+    for (const auto& define : defines) {
+        lines += "#define " + define.first;
+        if (!define.second.empty())
+            lines += " " + define.second;
+        lines += "\n";
+    }
+    // The #version line must stay the first statement of the shader.
+    size_t version = source.find("#version");
+    size_t lineEnd = (version == std::string::npos) ? std::string::npos : source.find('\n', version);
+    if (lineEnd == std::string::npos)
+        return lines + source;
+    std::string result = source;
+    result.insert(lineEnd + 1, lines);
+    return result;
+}
+
 void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& fragmentShaderSource) {
     std::cout << "Creating shader with a vertex and fragment shader elements.\n";
 
@@ -61,6 +86,9 @@ void Shader::CreateShader(const std::string& vertexShaderSource, const std::stri
     // These have been compiled already.
     glAttachShader(program,myVertexShader);
     glAttachShader(program,myFragmentShader);
+    // Lets ShaderCache save the linked program.
+    if (GLAD_GL_VERSION_4_1)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     // Link our programs that have been 'attached'
     glLinkProgram(program);
     glValidateProgram(program);
@@ -76,6 +104,10 @@ void Shader::CreateShader(const std::string& vertexShaderSource, const std::stri
         Log("CreateShader","ERROR, shader did not link! Were there compile errors in the shader?");
     }
 
+    // Point the shared uniform blocks at their binding points.
+    UniformBuffer::BindBlocks(program);
+    reflect(program);
+
     shaderID = program;
 }
 
@@ -95,6 +127,9 @@ void Shader::CreateShader(const std::string& vertexShaderSource, const std::stri
     glAttachShader(program, myFragmentShader);
     std::cout << "Shaders successfully attached.\n";
     
+    // Lets ShaderCache save the linked program.
+    if (GLAD_GL_VERSION_4_1)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
     // Link our programs that have been 'attached'
     glLinkProgram(program);
     std::cout << "Shader program linked.\n";
@@ -120,9 +155,96 @@ void Shader::CreateShader(const std::string& vertexShaderSource, const std::stri
         Log("CreateShader","ERROR, shader did not link! Were there compile errors in the shader?");
     }
 
+    // Point the shared uniform blocks at their binding points.
+    UniformBuffer::BindBlocks(program);
+    reflect(program);
+
+    shaderID = program;
+}
+
+// Alternate method initializer for drawing patches with tessellation
+// control and evaluation shaders (OpenGL 4.0).
+void Shader::CreateShader(const std::string& vertexShaderSource, const std::string& tessControlShaderSource,
+                          const std::string& tessEvaluationShaderSource, const std::string& fragmentShaderSource) {
+    std::cout << "Creating shader with a vertex, tessellation control, tessellation evaluation, and fragment shader elements.\n";
+    // Create a new program
+    unsigned int program = glCreateProgram();
+    // Compile our shaders
+    unsigned int myVertexShader = CompileShader(GL_VERTEX_SHADER, vertexShaderSource);
+    unsigned int myTessControlShader = CompileShader(GL_TESS_CONTROL_SHADER, tessControlShaderSource);
+    unsigned int myTessEvaluationShader = CompileShader(GL_TESS_EVALUATION_SHADER, tessEvaluationShaderSource);
+    unsigned int myFragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    // Link our program
+    // These have been compiled already.
+    glAttachShader(program, myVertexShader);
+    glAttachShader(program, myTessControlShader);
+    glAttachShader(program, myTessEvaluationShader);
+    glAttachShader(program, myFragmentShader);
+    // Lets ShaderCache save the linked program.
+    if (GLAD_GL_VERSION_4_1)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    // Link our programs that have been 'attached'
+    glLinkProgram(program);
+    glValidateProgram(program);
+
+    // Once the shaders have been linked in, we can delete them.
+    glDetachShader(program, myVertexShader);
+    glDetachShader(program, myTessControlShader);
+    glDetachShader(program, myTessEvaluationShader);
+    glDetachShader(program, myFragmentShader);
+
+    glDeleteShader(myVertexShader);
+    glDeleteShader(myTessControlShader);
+    glDeleteShader(myTessEvaluationShader);
+    glDeleteShader(myFragmentShader);
+
+    if(!CheckLinkStatus(program)){
+        Log("CreateShader","ERROR, shader did not link! Were there compile errors in the shader?");
+    }
+
+    // Point the shared uniform blocks at their binding points.
+    UniformBuffer::BindBlocks(program);
+    reflect(program);
+
     shaderID = program;
 }
 
+bool Shader::CreateShaderFromBinary(GLenum format, const std::vector<char>& binary) {
+    if (!GLAD_GL_VERSION_4_1 || binary.empty())
+        return false;
+    unsigned int program = glCreateProgram();
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glProgramBinary(program, format, binary.data(), (GLsizei)binary.size());
+    // A binary the driver rejects leaves the program unlinked, which
+    // is not an error: the caller builds it from source instead.
+    GLint result = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &result);
+    if (result == GL_FALSE) {
+        glDeleteProgram(program);
+        return false;
+    }
+
+    // Point the shared uniform blocks at their binding points.
+    UniformBuffer::BindBlocks(program);
+    reflect(program);
+
+    shaderID = program;
+    return true;
+}
+
+bool Shader::getBinary(GLenum& format, std::vector<char>& binary) const {
+    if (!GLAD_GL_VERSION_4_1 || shaderID == 0)
+        return false;
+    GLint length = 0;
+    glGetProgramiv(shaderID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return false;
+    binary.resize(length);
+    GLsizei written = 0;
+    glGetProgramBinary(shaderID, length, &written, &format, binary.data());
+    binary.resize(written);
+    return written > 0;
+}
 
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source){
     // Compile our shaders
@@ -135,6 +257,12 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
     } else if (type == GL_GEOMETRY_SHADER) {
         id = glCreateShader(GL_GEOMETRY_SHADER);
         std::cout << "Compiling geometry shader.\n";
+    } else if (type == GL_TESS_CONTROL_SHADER) {
+        id = glCreateShader(GL_TESS_CONTROL_SHADER);
+        std::cout << "Compiling tessellation control shader.\n";
+    } else if (type == GL_TESS_EVALUATION_SHADER) {
+        id = glCreateShader(GL_TESS_EVALUATION_SHADER);
+        std::cout << "Compiling tessellation evaluation shader.\n";
     } else if (type == GL_FRAGMENT_SHADER) {
         id = glCreateShader(GL_FRAGMENT_SHADER);
         std::cout << "Compiling fragment shader.\n";
@@ -160,6 +288,12 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
         } else if (type == GL_GEOMETRY_SHADER) {
         Log("CompileShader ERROR","GL_GEOMETRY_SHADER compilation failed!");
         Log("CompileShader ERROR",(const char*)errorMessages);
+        } else if (type == GL_TESS_CONTROL_SHADER) {
+        Log("CompileShader ERROR","GL_TESS_CONTROL_SHADER compilation failed!");
+        Log("CompileShader ERROR",(const char*)errorMessages);
+        } else if (type == GL_TESS_EVALUATION_SHADER) {
+        Log("CompileShader ERROR","GL_TESS_EVALUATION_SHADER compilation failed!");
+        Log("CompileShader ERROR",(const char*)errorMessages);
         } else if (type == GL_FRAGMENT_SHADER) {
         Log("CompileShader ERROR","GL_FRAGMENT_SHADER compilation failed!");
         Log("CompileShader ERROR",(const char*)errorMessages);
@@ -201,32 +335,169 @@ GLuint Shader::getID() const{
 }
 
 
+unsigned int Shader::getGeneration() const{
+    return m_generation;
+}
+
+void Shader::reflect(GLuint program){
+    m_uniforms.clear();
+    m_uniformIndices.clear();
+    m_generation = nextGeneration++;
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    std::vector<GLchar> nameBuffer(maxLength + 1);
+    for (GLint i = 0; i < count; i++) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = GL_NONE;
+        glGetActiveUniform(program, i, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+        std::string name(nameBuffer.data(), length);
+        // Arrays are listed once, as "name[0]".
+        std::string base = name;
+        if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+            base.resize(base.size() - 3);
+        for (GLint element = 0; element < size; element++) {
+            std::string elementName = (size > 1) ? base + "[" + std::to_string(element) + "]" : name;
+            // Members of uniform blocks have no location.
+            GLint location = glGetUniformLocation(program, elementName.c_str());
+            if (location < 0)
+                continue;
+            UniformInfo info = {};
+            info.location = location;
+            info.type = type;
+            m_uniformIndices[elementName] = (int)m_uniforms.size();
+            if (element == 0 && base != elementName)
+                m_uniformIndices[base] = (int)m_uniforms.size();
+            m_uniforms.push_back(info);
+        }
+    }
+}
+
+UniformHandle Shader::getUniform(const std::string& name) const{
+    UniformHandle uniform;
+    uniform.generation = m_generation;
+    auto found = m_uniformIndices.find(name);
+    if (found != m_uniformIndices.end())
+        uniform.index = found->second;
+    return uniform;
+}
+
+// Booleans and samplers are set as ints too.
+static bool typeMatches(GLenum reflected, GLenum expected){
+    if (reflected == expected)
+        return true;
+    if (expected != GL_INT)
+        return false;
+    return reflected == GL_BOOL || reflected == GL_SAMPLER_1D || reflected == GL_SAMPLER_2D ||
+           reflected == GL_SAMPLER_3D || reflected == GL_SAMPLER_CUBE || reflected == GL_SAMPLER_2D_MULTISAMPLE;
+}
+
+Shader::UniformInfo* Shader::update(const UniformHandle& uniform, GLenum type, const void* value, size_t size){
+    if (uniform.index < 0 || uniform.generation != m_generation)
+        return nullptr;
+    UniformInfo& info = m_uniforms[uniform.index];
+    if (!typeMatches(info.type, type)) {
+        Log("setUniform", "ERROR, the value does not match the type of the uniform");
+        return nullptr;
+    }
+    // Only this shader sets its program's uniforms, so the copy is
+    // always what the program holds.
+    if (info.hasValue && std::memcmp(info.value, value, size) == 0)
+        return nullptr;
+    std::memcpy(info.value, value, size);
+    info.hasValue = true;
+    return &info;
+}
+
 // Set our uniforms for our shader.
+// Note that we are 'looking' inside the shader for a particular
+// variable. This means the name has to exactly match! The name is only
+// looked up in the table built at link time; keep a handle from
+// getUniform() to skip even that.
 void Shader::setUniformMatrix4fv(const GLchar* name, const GLfloat* value){
-    // Note that we are now 'looking' inside the shader for a particular
-    // variable. This means the name has to exactly match!
-    GLint location = glGetUniformLocation(shaderID,name);
-
-    // Now update this information through our uniforms.
-    // glUniformMatrix4v means a 4x4 matrix of floats
-    glUniformMatrix4fv(location, 1, GL_FALSE, value);
+    setUniformMatrix4fv(getUniform(name), value);
 }
 
+// Set our uniforms for our shader (Useful for a normal matrix).
+void Shader::setUniformMatrix3fv(const GLchar* name, const GLfloat* value){
+    setUniformMatrix3fv(getUniform(name), value);
+}
 
 // Set our uniforms for our shader (Useful for a vec3).
 void Shader::setUniform3f(const GLchar* name, float v0, float v1, float v2){
-    GLint location = glGetUniformLocation(shaderID,name);
-    glUniform3f(location, v0, v1, v2);
+    setUniform3f(getUniform(name), v0, v1, v2);
+}
+
+// Sets 4 float values in our uniform (That is why the suffix is 4f).
+void Shader::setUniform4f(const GLchar* name, float v0, float v1, float v2, float v3){
+    setUniform4f(getUniform(name), v0, v1, v2, v3);
+}
+
+// Sets 2 float values in our uniform (That is why the suffix is 2f).
+void Shader::setUniform2f(const GLchar* name, float v0, float v1){
+    setUniform2f(getUniform(name), v0, v1);
 }
 
 // Sets 1 int value in our uniform (That is why the suffix is 1i).
 void Shader::setUniform1i(const GLchar* name, int value){
-    GLint location = glGetUniformLocation(shaderID,name);
-    glUniform1i(location, value);
+    setUniform1i(getUniform(name), value);
+}
+
+// Sets 2 int values in our uniform (That is why the suffix is 2i).
+void Shader::setUniform2i(const GLchar* name, int v0, int v1){
+    setUniform2i(getUniform(name), v0, v1);
 }
 
 // Sets 1 float value in our uniform (That is why the suffix is 1f).
 void Shader::setUniform1f(const GLchar* name, float value){
-    GLint location = glGetUniformLocation(shaderID,name);
-    glUniform1f(location, value);
+    setUniform1f(getUniform(name), value);
+}
+
+// The handle versions only reach OpenGL when the value changed.
+void Shader::setUniformMatrix4fv(const UniformHandle& uniform, const GLfloat* value){
+    // glUniformMatrix4v means a 4x4 matrix of floats
+    if (UniformInfo* info = update(uniform, GL_FLOAT_MAT4, value, 16 * sizeof(GLfloat)))
+        glUniformMatrix4fv(info->location, 1, GL_FALSE, value);
+}
+
+void Shader::setUniformMatrix3fv(const UniformHandle& uniform, const GLfloat* value){
+    if (UniformInfo* info = update(uniform, GL_FLOAT_MAT3, value, 9 * sizeof(GLfloat)))
+        glUniformMatrix3fv(info->location, 1, GL_FALSE, value);
+}
+
+void Shader::setUniform4f(const UniformHandle& uniform, float v0, float v1, float v2, float v3){
+    const float value[] = {v0, v1, v2, v3};
+    if (UniformInfo* info = update(uniform, GL_FLOAT_VEC4, value, sizeof(value)))
+        glUniform4f(info->location, v0, v1, v2, v3);
+}
+
+void Shader::setUniform3f(const UniformHandle& uniform, float v0, float v1, float v2){
+    const float value[] = {v0, v1, v2};
+    if (UniformInfo* info = update(uniform, GL_FLOAT_VEC3, value, sizeof(value)))
+        glUniform3f(info->location, v0, v1, v2);
+}
+
+void Shader::setUniform2f(const UniformHandle& uniform, float v0, float v1){
+    const float value[] = {v0, v1};
+    if (UniformInfo* info = update(uniform, GL_FLOAT_VEC2, value, sizeof(value)))
+        glUniform2f(info->location, v0, v1);
+}
+
+void Shader::setUniform1i(const UniformHandle& uniform, int value){
+    if (UniformInfo* info = update(uniform, GL_INT, &value, sizeof(value)))
+        glUniform1i(info->location, value);
+}
+
+void Shader::setUniform2i(const UniformHandle& uniform, int v0, int v1){
+    const int value[] = {v0, v1};
+    if (UniformInfo* info = update(uniform, GL_INT_VEC2, value, sizeof(value)))
+        glUniform2i(info->location, v0, v1);
+}
+
+void Shader::setUniform1f(const UniformHandle& uniform, float value){
+    if (UniformInfo* info = update(uniform, GL_FLOAT, &value, sizeof(value)))
+        glUniform1f(info->location, value);
 }
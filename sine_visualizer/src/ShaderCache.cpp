@@ -0,0 +1,316 @@
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+#if defined(MINGW)
+    #include <direct.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+// Start of every saved binary. The hash is kept too, so a file that
+// was renamed or cut short is never handed to the driver.
+struct BinaryHeader {
+    char magic[4];
+    uint32_t format;
+    uint64_t hash;
+    uint64_t length;
+};
+static const char BINARY_MAGIC[4] = {'S', 'V', 'P', 'B'};
+
+// 64 bit FNV-1a, which gives the same hash on every platform and run
+static uint64_t hashString(uint64_t hash, const std::string& str) {
+    for (unsigned char c : str) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    // Keeps "ab" + "c" apart from "a" + "bc".
+    hash ^= 0xFF;
+    hash *= 1099511628211ull;
+    return hash;
+}
+
+static std::string glString(GLenum name) {
+    const GLubyte* str = glGetString(name);
+    return (str != nullptr) ? (const char*)str : "";
+}
+
+static std::string fileName(const std::string& path) {
+    size_t slash = path.find_last_of("/\\");
+    return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+ShaderCache& ShaderCache::Get() {
+    static ShaderCache shaderCache;
+    return shaderCache;
+}
+
+ShaderCache::ShaderCache() : m_binaryDirectory("./shader_cache"), m_binariesSupported(-1) {
+}
+
+ShaderCache::~ShaderCache() {
+    // Programs are deleted in Shutdown(), while the context still
+    // exists.
+    for (auto& variant : m_programs)
+        variant.second.program.release();
+}
+
+void ShaderCache::Shutdown() {
+    m_programs.clear();
+    m_sources.clear();
+    m_binariesSupported = -1;
+}
+
+void ShaderCache::SetBinaryDirectory(const std::string& directory) {
+    m_binaryDirectory = directory;
+}
+
+const std::string& ShaderCache::source(Shader& shader, const std::string& file) {
+    auto found = m_sources.find(file);
+    if (found != m_sources.end())
+        return found->second;
+    // Empty while the file is read, so a file that includes itself
+    // gets nothing instead of recursing forever.
+    std::string& text = m_sources[file];
+    std::string loaded = shader.LoadShader(file);
+
+    // Each #include "name" line is replaced by the file, named
+    // relative to the directory of the one including it.
+    size_t slash = file.find_last_of("/\\");
+    std::string directory = (slash == std::string::npos) ? "" : file.substr(0, slash + 1);
+    size_t lineStart = 0;
+    while (lineStart < loaded.size()) {
+        size_t lineEnd = loaded.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = loaded.size();
+        size_t first = loaded.find_first_not_of(" \t", lineStart);
+        if (first < lineEnd && loaded.compare(first, 8, "#include") == 0) {
+            size_t open = loaded.find('"', first);
+            size_t close = (open < lineEnd) ? loaded.find('"', open + 1) : std::string::npos;
+            if (close < lineEnd) {
+                std::string included = source(shader, directory + loaded.substr(open + 1, close - open - 1));
+                loaded.replace(lineStart, lineEnd - lineStart, included);
+                lineEnd = lineStart + included.size();
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    text = loaded;
+    return text;
+}
+
+bool ShaderCache::binariesSupported() {
+    if (m_binariesSupported < 0) {
+        GLint formats = 0;
+        if (GLAD_GL_VERSION_4_1)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        m_binariesSupported = (formats > 0) ? 1 : 0;
+    }
+    return m_binariesSupported == 1 && !m_binaryDirectory.empty();
+}
+
+std::string ShaderCache::binaryPath(uint64_t hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+    return m_binaryDirectory + "/" + name;
+}
+
+bool ShaderCache::loadBinary(Shader& program, uint64_t hash) {
+    std::ifstream file(binaryPath(hash), std::ios::binary);
+    if (!file.is_open())
+        return false;
+    BinaryHeader header;
+    if (!file.read((char*)&header, sizeof(header)) ||
+        std::memcmp(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 ||
+        header.hash != hash || header.length == 0 || header.length > (1u << 30))
+        return false;
+    std::vector<char> binary(header.length);
+    if (!file.read(binary.data(), binary.size()))
+        return false;
+    return program.CreateShaderFromBinary(header.format, binary);
+}
+
+void ShaderCache::saveBinary(const Shader& program, uint64_t hash) {
+    GLenum format = 0;
+    std::vector<char> binary;
+    if (!program.getBinary(format, binary))
+        return;
+    // Fails harmlessly when the directory already exists.
+#if defined(MINGW)
+    _mkdir(m_binaryDirectory.c_str());
+#else
+    mkdir(m_binaryDirectory.c_str(), 0755);
+#endif
+    // Written to another name first, so a program that is stopped half
+    // way never leaves a broken binary behind.
+    std::string path = binaryPath(hash);
+    std::string partialPath = path + ".tmp";
+    std::ofstream file(partialPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cout << "(ShaderCache.cpp) Unable to write " << partialPath << "\n";
+        return;
+    }
+    BinaryHeader header;
+    std::memcpy(header.magic, BINARY_MAGIC, sizeof(BINARY_MAGIC));
+    header.format = format;
+    header.hash = hash;
+    header.length = binary.size();
+    file.write((const char*)&header, sizeof(header));
+    file.write(binary.data(), binary.size());
+    file.close();
+    std::remove(path.c_str());
+    std::rename(partialPath.c_str(), path.c_str());
+}
+
+std::unique_ptr<Shader> ShaderCache::build(const ShaderFiles& files, const ShaderDefines& defines,
+                                           bool useBinary, bool save, bool& fromBinary) {
+    std::unique_ptr<Shader> program(new Shader);
+    std::string vertexShader = Shader::AddDefines(source(*program, files.vertex), defines);
+    std::string fragmentShader = Shader::AddDefines(source(*program, files.fragment), defines);
+    std::string tessControlShader, tessEvaluationShader;
+    if (!files.tessControl.empty()) {
+        tessControlShader = Shader::AddDefines(source(*program, files.tessControl), defines);
+        tessEvaluationShader = Shader::AddDefines(source(*program, files.tessEvaluation), defines);
+    }
+
+    // The same sources on the same driver always link to the same
+    // program.
+    bool binaries = binariesSupported();
+    uint64_t hash = 14695981039346656037ull;
+    if (binaries) {
+        hash = hashString(hash, glString(GL_VENDOR));
+        hash = hashString(hash, glString(GL_RENDERER));
+        hash = hashString(hash, glString(GL_VERSION));
+        hash = hashString(hash, vertexShader);
+        hash = hashString(hash, tessControlShader);
+        hash = hashString(hash, tessEvaluationShader);
+        hash = hashString(hash, fragmentShader);
+    }
+
+    fromBinary = binaries && useBinary && loadBinary(*program, hash);
+    if (fromBinary) {
+        std::cout << "Loaded program binary " << binaryPath(hash) << "\n";
+        return program;
+    }
+    if (!files.tessControl.empty())
+        program->CreateShader(vertexShader, tessControlShader, tessEvaluationShader, fragmentShader);
+    else
+        program->CreateShader(vertexShader, fragmentShader);
+    if (binaries && save)
+        saveBinary(*program, hash);
+    return program;
+}
+
+Shader* ShaderCache::GetProgram(const ShaderFiles& files, const ShaderDefines& defines) {
+    // The defines are ordered by name, so the same variant always has
+    // the same key.
+    std::string key = files.vertex + "|" + files.tessControl + "|" + files.tessEvaluation + "|" + files.fragment;
+    for (const auto& define : defines)
+        key += "|" + define.first + "=" + define.second;
+    auto found = m_programs.find(key);
+    if (found != m_programs.end())
+        return found->second.program.get();
+
+    Variant variant;
+    variant.files = files;
+    variant.defines = defines;
+    auto start = std::chrono::steady_clock::now();
+    variant.program = build(files, defines, true, true, variant.fromBinary);
+    variant.buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Shader* result = variant.program.get();
+    m_programs.emplace(key, std::move(variant));
+    return result;
+}
+
+size_t ShaderCache::GetSize() const {
+    return m_programs.size();
+}
+
+bool ShaderCache::StartupReport(std::ostream& out) {
+    if (m_programs.empty())
+        return false;
+    bool binaries = binariesSupported();
+
+    // Everything is built before printing, since building logs too.
+    struct Row {
+        std::string name;
+        double start;
+        bool startFromBinary;
+        double cold;
+        double warm;
+        bool warmFromBinary;
+    };
+    std::vector<Row> rows;
+    for (const auto& entry : m_programs) {
+        const Variant& variant = entry.second;
+        Row row = {fileName(variant.files.vertex), variant.buildMilliseconds, variant.fromBinary, 0.0, 0.0, false};
+        if (!variant.files.tessControl.empty())
+            row.name += " " + fileName(variant.files.tessControl) + " " + fileName(variant.files.tessEvaluation);
+        row.name += " " + fileName(variant.files.fragment);
+        for (const auto& define : variant.defines)
+            row.name += " " + define.first + (define.second.empty() ? "" : "=" + define.second);
+
+        // Files are read again too, as they would be on a first start.
+        // Nothing is saved, so the binaries stay the ones the program
+        // started with.
+        m_sources.clear();
+        bool fromBinary = false;
+        auto start = std::chrono::steady_clock::now();
+        build(variant.files, variant.defines, false, false, fromBinary);
+        row.cold = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (binaries) {
+            m_sources.clear();
+            start = std::chrono::steady_clock::now();
+            build(variant.files, variant.defines, true, false, row.warmFromBinary);
+            row.warm = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        rows.push_back(row);
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.name < b.name; });
+
+    // The driver may keep a shader cache of its own, which makes
+    // compiling the same source again faster than a first start.
+    out << "\n[ShaderCache] Startup: " << rows.size() << " programs. \"This start\" is how each was built when first used,\n"
+        << "    from source (src) or from its binary (bin). Cold builds it again from source, warm from the binary.\n";
+    if (!binaries)
+        out << "    Program binaries are " << (m_binaryDirectory.empty() ? "turned off" : "not supported by this driver")
+            << ", so every start is cold.\n";
+    else
+        out << "    Binaries are kept in " << m_binaryDirectory << ".\n";
+    out << "    " << std::left << std::setw(66) << "Program" << std::right << std::setw(14) << "This start ms"
+        << std::setw(10) << "Cold ms";
+    if (binaries)
+        out << std::setw(10) << "Warm ms";
+    out << "\n" << std::fixed << std::setprecision(1);
+    double startTotal = 0.0;
+    double coldTotal = 0.0;
+    double warmTotal = 0.0;
+    bool allWarm = true;
+    for (const Row& row : rows) {
+        startTotal += row.start;
+        coldTotal += row.cold;
+        out << "    " << std::left << std::setw(66) << row.name << std::right << std::setw(10) << row.start
+            << (row.startFromBinary ? " bin" : " src") << std::setw(10) << row.cold;
+        if (binaries) {
+            warmTotal += row.warm;
+            allWarm = allWarm && row.warmFromBinary;
+            out << std::setw(10) << row.warm << (row.warmFromBinary ? "" : "  (binary refused, compiled)");
+        }
+        out << "\n";
+    }
+    out << "    " << std::left << std::setw(66) << "Total" << std::right << std::setw(14) << startTotal
+        << std::setw(10) << coldTotal;
+    if (binaries) {
+        out << std::setw(10) << warmTotal;
+        if (allWarm && warmTotal > 0.0)
+            out << "  (warm " << std::setprecision(2) << coldTotal / warmTotal << "x faster than cold)";
+    }
+    out << std::defaultfloat << "\n";
+    return true;
+}
@@ -1,9 +1,20 @@
 #include "Terrain.h"
 #include "Image.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "GridIndices.h"
+
+#include <algorithm>
+
+// Defined here too, since std::min() takes them by reference.
+const int Terrain::DEFAULT_TILE_SIZE;
+const int Terrain::DEFAULT_PROJECTED_CELL;
+const int Terrain::MAX_INSTANCE_PATCH;
+const int Terrain::MAX_SEGMENTS;
 
 // Constructor for our object
 // Calls the initialization method
-Terrain::Terrain(int xSegs, int zSegs) : xSegments(xSegs), zSegments(zSegs) {
+Terrain::Terrain(int xSegs, int zSegs, GridMode gridMode, int tileSize, bool optimizeVertexCache) : xSegments(xSegs), zSegments(zSegs), m_gridMode(gridMode), m_optimizeVertexCache(optimizeVertexCache), m_tileSize(tileSize) {
     std::cout << "(Terrain.cpp) Constructor Called \n";
     init();
 }
@@ -37,7 +48,13 @@ Terrain::Terrain(int xSegs, int zSegs, std::string fileName) : xSegments(xSegs),
 // Destructor
 Terrain::~Terrain(){
     if(heightData!=nullptr){
-        delete heightData;
+        delete[] heightData;
+    }
+    for(Tile& tile : m_tiles){
+        delete tile.buffer;
+    }
+    if(m_tessQueries[0] != 0){
+        glDeleteQueries(2, m_tessQueries);
     }
 }
 
@@ -46,8 +63,25 @@ Terrain::~Terrain(){
 // http://www.learnopengles.com/wordpress/wp-content/uploads/2012/05/vbo.png
 // of what we are trying to do.
 void Terrain::init(){
+    // A procedural grid only needs an empty vertex array, so building
+    // it takes the same time and memory for any size.
+    if (m_gridMode == GridMode::Procedural || m_gridMode == GridMode::Projected) {
+        myBuffer.CreateEmptyLayout();
+    }
+    else if (m_gridMode == GridMode::Tiles) {
+        initTiles();
+    }
+    else if (m_gridMode == GridMode::Lod) {
+        initLod();
+    }
+    else if (m_gridMode == GridMode::Tessellation) {
+        initTessellation();
+    }
+    else if (m_gridMode == GridMode::Instanced) {
+        initInstanced();
+    }
     // Create a terrain ia texture was provided.
-    if (!m_texturePath.empty()) {
+    else if (!m_texturePath.empty()) {
         // Create the initial grid of vertices.
         for(int z = 0 ; z < zSegments; ++z){
             for(int x = 0; x < xSegments; ++x){
@@ -66,19 +100,19 @@ void Terrain::init(){
             // previous row (see below), and the first vertex of the new row.
             // This is the degenerate begin, which repeats the first vertex.
             if (z > 0)
-                geometry.addIndex(z * zSegments);
+                geometry.addIndex(z * xSegments);
                 
             for(int x = 0; x < xSegments - 1; ++x){
                 geometry.makeTriangle(
-                    x + (z * zSegments),
-                    x + (z * zSegments) + xSegments,
-                    x + (z * zSegments) + 1
+                    x + (z * xSegments),
+                    x + (z * xSegments) + xSegments,
+                    x + (z * xSegments) + 1
                 );
 
                 geometry.makeTriangle(
-                    x + (z * zSegments) + 1,
-                    x + (z * zSegments) + xSegments,
-                    x + (z * zSegments) + xSegments + 1
+                    x + (z * xSegments) + 1,
+                    x + (z * xSegments) + xSegments,
+                    x + (z * xSegments) + xSegments + 1
                 );
             }
 
@@ -86,7 +120,7 @@ void Terrain::init(){
             // in a row to properly render each row. Two vertices are necessary to
             // maintain the winding order of the grid.
             if (z < zSegments - 2)
-                geometry.addIndex(((z + 1) * zSegments) + (xSegments - 1));
+                geometry.addIndex(((z + 1) * xSegments) + (xSegments - 1));
         }
         // Finally generate a simple 'array of bytes' that contains
         // everything for our buffer to work with.
@@ -98,46 +132,587 @@ void Terrain::init(){
                             geometry.getIndicesSize(),
                             geometry.getData(),
                             geometry.getIndicesData());
+        m_bufferBytes = geometry.getSizeInBytes() + geometry.getIndicesSize() * sizeof(unsigned int);
     }
     // Create a flat plane when no texture map is provided.
     else {
-        for(int z = 0 ; z < zSegments; ++z){
+        buildFlatPlane(geometry, xSegments, zSegments);
+        if (m_optimizeVertexCache)
+            geometry.optimizeVertexCache();
+
+        // Create a buffer and set the stride of information
+        myBuffer.CreateBufferLayout(3,
+                    geometry.getSize(),
+                    geometry.getIndicesSize(),
+                    geometry.getData(),
+                    geometry.getIndexBytes(),
+                    geometry.getIndexTypeSize());
+        m_bufferBytes = geometry.getSizeInBytes() + geometry.getIndicesSize() * geometry.getIndexTypeSize();
+    }
+
+}
+
+// Each band of rows writes its vertices straight into its own part of
+// the buffer that is uploaded, so no thread touches another's data.
+void Terrain::buildFlatPlane(Geometry& geometry, int xSegments, int zSegments){
+    // Only positions are needed, so each vertex is 3 floats.
+    geometry.allocateVertices(xSegments * zSegments, ATTRIBUTE_POSITION);
+    const int ROW_GRAIN = 16;
+    ThreadPool::Get().ParallelFor(zSegments, ROW_GRAIN, [&geometry, xSegments, zSegments](int firstRow, int lastRow) {
+        float* vertex = geometry.getVertex(firstRow * xSegments);
+        for(int z = firstRow; z < lastRow; ++z){
             for(int x = 0; x < xSegments; ++x){
                 // create a plane if no texture was provided
-                geometry.addVertex(x - xSegments / 2.0f, 0.0f, z - zSegments / 2.0f);
+                *vertex++ = x - xSegments / 2.0f;
+                *vertex++ = 0.0f;
+                *vertex++ = z - zSegments / 2.0f;
             }
         }
-        // No need to use the geometry make triangle method when
-        // there is no texture provided. The normals will be
-        // computed in the geometry shader. Adding the indices
-        // is enough
-        for(int z = 0 ; z < zSegments - 1; ++z){
-            if (z > 0)
-                geometry.addIndex(z * zSegments);
-                
-            for(int x = 0; x < xSegments - 1; ++x){
-                geometry.addIndex(x + (z * zSegments));
-                geometry.addIndex(x + (z * zSegments) + xSegments);
-                geometry.addIndex(x + (z * zSegments) + 1);
+    });
+    // No need to use the geometry make triangle method when
+    // there is no texture provided. The normals will be
+    // computed in the vertex shader. One strip per pair of rows
+    // is enough.
+    geometry.makeGridStrips(xSegments, zSegments);
+}
 
-                geometry.addIndex(x + (z * zSegments) + 1);
-                geometry.addIndex(x + (z * zSegments) + xSegments);
-                geometry.addIndex(x + (z * zSegments) + xSegments + 1);
+// Neighbouring tiles share their edge vertices, so the tiles cover
+// exactly the same triangles as the single buffer. Vertices keep their
+// position on the whole plane, so the shaders do not change.
+void Terrain::initTiles(){
+    if (m_tileSize < 1)
+        m_tileSize = DEFAULT_TILE_SIZE;
+    for(int z0 = 0; z0 < zSegments - 1; z0 += m_tileSize){
+        int tileZ = std::min(m_tileSize, zSegments - 1 - z0) + 1;
+        for(int x0 = 0; x0 < xSegments - 1; x0 += m_tileSize){
+            int tileX = std::min(m_tileSize, xSegments - 1 - x0) + 1;
+
+            Geometry tileGeometry;
+            tileGeometry.allocateVertices(tileX * tileZ, ATTRIBUTE_POSITION);
+            float* vertex = tileGeometry.getVertex(0);
+            for(int z = z0; z < z0 + tileZ; ++z){
+                for(int x = x0; x < x0 + tileX; ++x){
+                    *vertex++ = x - xSegments / 2.0f;
+                    *vertex++ = 0.0f;
+                    *vertex++ = z - zSegments / 2.0f;
+                }
             }
-            if (z < zSegments - 2)
-                geometry.addIndex(((z + 1) * zSegments) + (xSegments - 1));
+            tileGeometry.makeGridStrips(tileX, tileZ);
+            if (m_optimizeVertexCache)
+                tileGeometry.optimizeVertexCache();
+
+            Tile tile;
+            tile.buffer = new Buffer();
+            tile.buffer->CreateBufferLayout(3,
+                        tileGeometry.getSize(),
+                        tileGeometry.getIndicesSize(),
+                        tileGeometry.getData(),
+                        tileGeometry.getIndexBytes(),
+                        tileGeometry.getIndexTypeSize());
+            tile.indexCount = tileGeometry.getIndicesSize();
+            tile.indexType = (tileGeometry.getIndexTypeSize() == sizeof(unsigned short)) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            tile.triangles = 2ULL * (tileX - 1) * (tileZ - 1);
+            m_tiles.push_back(tile);
+            m_bufferBytes += tileGeometry.getSizeInBytes() + tileGeometry.getIndicesSize() * tileGeometry.getIndexTypeSize();
+
+            // The height is set by cull(), once the amplitude is known.
+            m_tileBounds.Add(glm::vec3(x0 - xSegments / 2.0f, 0.0f, z0 - zSegments / 2.0f),
+                             glm::vec3(x0 + tileX - 1 - xSegments / 2.0f, 0.0f, z0 + tileZ - 1 - zSegments / 2.0f));
         }
-        // Finally generate a simple 'array of bytes' that contains
-        // everything for our buffer to work with.
-        geometry.gen();
+    }
+    // Everything is drawn until the first cull().
+    m_tileVisible.assign(m_tiles.size(), 1);
+    m_lastCull.tiles = (int)m_tiles.size();
+    m_lastCull.tilesDrawn = m_lastCull.tiles;
+    m_lastCull.triangles = getPlaneTriangleCount();
+    m_lastCull.trianglesDrawn = m_lastCull.triangles;
+}
 
+// The patch is a grid of unit positions that the vertex shader places
+// and scales. Its indices are stored one quadrant after another, so a
+// single quadrant can be drawn on its own.
+void Terrain::initLod(){
+    int quads = 2;
+    while (quads < m_tileSize && quads < 128)
+        quads *= 2;
+    m_tileSize = quads;
+    m_lod.Create(xSegments, zSegments, quads);
 
-        // Create a buffer and set the stride of information
-        myBuffer.CreateBufferLayout(3,
-                    geometry.getSize(),
-                    geometry.getIndicesSize(),
-                    geometry.getData(),
-                    geometry.getIndicesData());
+    int side = quads + 1;
+    geometry.allocateVertices(side * side, ATTRIBUTE_POSITION);
+    float* vertex = geometry.getVertex(0);
+    for(int z = 0; z < side; ++z){
+        for(int x = 0; x < side; ++x){
+            *vertex++ = (float)x / quads;
+            *vertex++ = 0.0f;
+            *vertex++ = (float)z / quads;
+        }
+    }
+
+    typedef GridStripBuilder<unsigned short> Builder;
+    int quadrantSide = quads / 2 + 1;
+    std::vector<unsigned short> quadrant = Builder::Build(quadrantSide, quadrantSide);
+    std::vector<unsigned short> indices;
+    for(int q = 0; q < 4; ++q){
+        if (q > 0)
+            indices.push_back(Builder::RESTART_INDEX);
+        m_quadrantOffset[q] = indices.size();
+        int offsetX = (q & 1) * (quads / 2);
+        int offsetZ = (q >> 1) * (quads / 2);
+        for(unsigned short index : quadrant){
+            if (index == Builder::RESTART_INDEX) {
+                indices.push_back(index);
+                continue;
+            }
+            int row = index / quadrantSide;
+            int column = index % quadrantSide;
+            indices.push_back((unsigned short)((offsetZ + row) * side + offsetX + column));
+        }
+        m_quadrantCount[q] = indices.size() - m_quadrantOffset[q];
+    }
+    m_lodIndexCount = indices.size();
+
+    myBuffer.CreateBufferLayout(3,
+                geometry.getSize(),
+                indices.size(),
+                geometry.getData(),
+                indices.data(),
+                sizeof(unsigned short));
+    m_bufferBytes = geometry.getSizeInBytes() + indices.size() * sizeof(unsigned short);
+}
+
+// Patch corners are every m_tileSize vertices of the plane, and the
+// last row and column of patches are cut short to end on the plane's
+// edge. The wave is only applied after tessellation, so the corners
+// lie flat.
+void Terrain::initTessellation(){
+    if (m_tileSize < 1)
+        m_tileSize = DEFAULT_TILE_SIZE;
+    int patchesX = (xSegments - 2) / m_tileSize + 1;
+    int patchesZ = (zSegments - 2) / m_tileSize + 1;
+    int cornersX = patchesX + 1;
+    int cornersZ = patchesZ + 1;
+
+    geometry.allocateVertices(cornersX * cornersZ, ATTRIBUTE_POSITION);
+    float* vertex = geometry.getVertex(0);
+    for(int z = 0; z < cornersZ; ++z){
+        for(int x = 0; x < cornersX; ++x){
+            *vertex++ = std::min(x * m_tileSize, xSegments - 1) - xSegments / 2.0f;
+            *vertex++ = 0.0f;
+            *vertex++ = std::min(z * m_tileSize, zSegments - 1) - zSegments / 2.0f;
+        }
+    }
+
+    // Corners go around the quad in the order tessCtrl.glsl expects:
+    // (u, v) = (0, 0), (1, 0), (1, 1) and (0, 1), with u along X.
+    std::vector<unsigned int> indices;
+    indices.reserve(4 * patchesX * patchesZ);
+    for(int z = 0; z < patchesZ; ++z){
+        for(int x = 0; x < patchesX; ++x){
+            unsigned int corner = z * cornersX + x;
+            indices.push_back(corner);
+            indices.push_back(corner + 1);
+            indices.push_back(corner + cornersX + 1);
+            indices.push_back(corner + cornersX);
+        }
+    }
+    m_tessIndexCount = indices.size();
+
+    myBuffer.CreateBufferLayout(3,
+                geometry.getSize(),
+                indices.size(),
+                geometry.getData(),
+                indices.data());
+    m_bufferBytes = geometry.getSizeInBytes() + indices.size() * sizeof(unsigned int);
+
+    glGenQueries(2, m_tessQueries);
+}
+
+// One patch of m_tileSize x m_tileSize quads is stored, with its
+// vertices at whole numbers from 0 to m_tileSize. The vertex shader
+// moves each instance to its place on the plane, so the buffers have
+// the same size for any plane.
+void Terrain::initInstanced(){
+    if (m_tileSize < 1)
+        m_tileSize = DEFAULT_TILE_SIZE;
+    m_tileSize = std::min(m_tileSize, MAX_INSTANCE_PATCH);
+    int side = m_tileSize + 1;
+    geometry.allocateVertices(side * side, ATTRIBUTE_POSITION);
+    float* vertex = geometry.getVertex(0);
+    for(int z = 0; z < side; ++z){
+        for(int x = 0; x < side; ++x){
+            *vertex++ = (float)x;
+            *vertex++ = 0.0f;
+            *vertex++ = (float)z;
+        }
+    }
+    geometry.makeGridStrips(side, side);
+    if (m_optimizeVertexCache)
+        geometry.optimizeVertexCache();
+    m_instanceIndexCount = geometry.getIndicesSize();
+
+    myBuffer.CreateBufferLayout(3,
+                geometry.getSize(),
+                geometry.getIndicesSize(),
+                geometry.getData(),
+                geometry.getIndexBytes(),
+                geometry.getIndexTypeSize());
+    m_bufferBytes = geometry.getSizeInBytes() + geometry.getIndicesSize() * geometry.getIndexTypeSize();
+}
+
+// Patches along X and Z that cover the plane. The last row and column
+// of patches may reach past it (see gridPosition() in vert.glsl).
+int Terrain::instancePatchesX(){
+    return (xSegments < 2) ? 0 : (xSegments - 2) / m_tileSize + 1;
+}
+
+int Terrain::instancePatchesZ(){
+    return (zSegments < 2) ? 0 : (zSegments - 2) / m_tileSize + 1;
+}
+
+bool Terrain::resize(int xSegs, int zSegs){
+    if (m_gridMode != GridMode::Instanced && m_gridMode != GridMode::Procedural && m_gridMode != GridMode::Projected)
+        return false;
+    xSegments = xSegs;
+    zSegments = zSegs;
+    return true;
+}
+
+// Each row of the grid is one strip of 2 * xSegments vertices that
+// zig-zags between rows z and z + 1. Rows are joined by repeating the
+// last vertex of a row and the first vertex of the next, which adds 2
+// degenerate vertices per row (see gridPosition() in vert.glsl).
+static unsigned int proceduralStripCount(int xSegments, int zSegments) {
+    if (xSegments < 2 || zSegments < 2)
+        return 0;
+    unsigned int rows = zSegments - 1;
+    return rows * (2 * xSegments) + (rows - 1) * 2;
+}
+
+void Terrain::render(){
+    // Optimized grids are triangle lists, and the restart index never
+    // appears in them.
+    GLenum triangles = m_optimizeVertexCache ? GL_TRIANGLES : GL_TRIANGLE_STRIP;
+    if (m_gridMode == GridMode::Tiles) {
+        diffuseMap.Bind(0);
+        GLenum mode = (m_renderMode == "points") ? GL_POINTS : triangles;
+        glEnable(GL_PRIMITIVE_RESTART);
+        for (size_t i = 0; i < m_tiles.size(); i++) {
+            if (!m_tileVisible[i])
+                continue;
+            const Tile& tile = m_tiles[i];
+            tile.buffer->Bind();
+            glPrimitiveRestartIndex((tile.indexType == GL_UNSIGNED_SHORT) ? 0xFFFF : 0xFFFFFFFF);
+            glDrawElements(mode, tile.indexCount, tile.indexType, nullptr);
+        }
+        glDisable(GL_PRIMITIVE_RESTART);
+        return;
+    }
+    if (m_gridMode == GridMode::Lod) {
+        if (m_shader == nullptr)
+            return;
+        Bind();
+        GLenum mode = (m_renderMode == "points") ? GL_POINTS : GL_TRIANGLE_STRIP;
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex(0xFFFF);
+        m_shader->setUniform3f(m_uniforms.lodEye, m_lodEye.x, m_lodEye.y, m_lodEye.z);
+        for (const LodPatch& patch : m_lodPatches) {
+            glm::vec2 morph = m_lod.GetMorphRange(patch.level);
+            m_shader->setUniform4f(m_uniforms.lodPatch, patch.x, patch.z, patch.size, (float)m_lod.GetPatchQuads());
+            m_shader->setUniform2f(m_uniforms.lodMorph, morph.x, morph.y);
+            if (patch.quadrant < 0) {
+                glDrawElements(mode, m_lodIndexCount, GL_UNSIGNED_SHORT, nullptr);
+            } else {
+                glDrawElements(mode, m_quadrantCount[patch.quadrant], GL_UNSIGNED_SHORT,
+                               (const void*)(m_quadrantOffset[patch.quadrant] * sizeof(unsigned short)));
+            }
+        }
+        glDisable(GL_PRIMITIVE_RESTART);
+        return;
+    }
+    if (m_gridMode == GridMode::Tessellation) {
+        // The triangles counted two frames ago are read if the GPU is
+        // done with them, and skipped otherwise.
+        int query = m_tessQuery;
+        if (m_tessQueryPending[query]) {
+            GLint available = 0;
+            glGetQueryObjectiv(m_tessQueries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (available) {
+                GLuint64 triangles = 0;
+                glGetQueryObjectui64v(m_tessQueries[query], GL_QUERY_RESULT, &triangles);
+                m_lastCull.trianglesDrawn = triangles;
+                m_trianglesGenerated += triangles;
+                m_tessFrames++;
+            }
+        }
+        Bind();
+        glPatchParameteri(GL_PATCH_VERTICES, 4);
+        glBeginQuery(GL_PRIMITIVES_GENERATED, m_tessQueries[query]);
+        glDrawElements(GL_PATCHES, m_tessIndexCount, GL_UNSIGNED_INT, nullptr);
+        glEndQuery(GL_PRIMITIVES_GENERATED);
+        m_tessQueryPending[query] = true;
+        m_tessQuery = 1 - query;
+        return;
+    }
+    if (m_gridMode == GridMode::Instanced) {
+        Bind();
+        GLenum mode = (m_renderMode == "points") ? GL_POINTS : triangles;
+        GLenum indexType = (geometry.getIndexTypeSize() == sizeof(unsigned short)) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        glEnable(GL_PRIMITIVE_RESTART);
+        glPrimitiveRestartIndex((indexType == GL_UNSIGNED_SHORT) ? 0xFFFF : 0xFFFFFFFF);
+        glDrawElementsInstanced(mode, m_instanceIndexCount, indexType, nullptr,
+                                instancePatchesX() * instancePatchesZ());
+        glDisable(GL_PRIMITIVE_RESTART);
+        return;
+    }
+    if (m_gridMode == GridMode::Projected) {
+        Bind();
+        GLenum mode = (m_renderMode == "points") ? GL_POINTS : GL_TRIANGLE_STRIP;
+        glDrawArrays(mode, 0, proceduralStripCount(m_projectedX, m_projectedZ));
+        return;
     }
+    if (m_gridMode != GridMode::Procedural) {
+        Object::render();
+        return;
+    }
+    Bind();
+    if (m_renderMode == "points") {
+        glDrawArrays(GL_POINTS, 0, xSegments * zSegments);
+    } else {
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, proceduralStripCount(xSegments, zSegments));
+    }
+}
+
+void Terrain::setUniforms(Shader& shader){
+    // 0 reads the position attribute, 1 generates a strip,
+    // 2 generates one point per vertex, 3 places LOD patches, 4
+    // projects a strip covering the screen onto the plane, and 5
+    // places instanced patches.
+    int gridMode = 0;
+    if (m_gridMode == GridMode::Procedural)
+        gridMode = (m_renderMode == "points") ? 2 : 1;
+    else if (m_gridMode == GridMode::Lod)
+        gridMode = 3;
+    else if (m_gridMode == GridMode::Projected)
+        gridMode = 4;
+    else if (m_gridMode == GridMode::Instanced)
+        gridMode = 5;
+    m_shader = &shader;
+    if (m_uniforms.generation != shader.getGeneration()) {
+        m_uniforms.generation = shader.getGeneration();
+        m_uniforms.gridMode = shader.getUniform("gridMode");
+        m_uniforms.gridSize = shader.getUniform("gridSize");
+        m_uniforms.instancePatch = shader.getUniform("instancePatch");
+        m_uniforms.viewportSize = shader.getUniform("viewportSize");
+        m_uniforms.tessPixels = shader.getUniform("tessPixels");
+        m_uniforms.tessError = shader.getUniform("tessError");
+        m_uniforms.lodEye = shader.getUniform("lodEye");
+        m_uniforms.lodPatch = shader.getUniform("lodPatch");
+        m_uniforms.lodMorph = shader.getUniform("lodMorph");
+        m_uniforms.projectorInverse = shader.getUniform("projectorInverse");
+        m_uniforms.projectorHeight = shader.getUniform("projectorHeight");
+        m_uniforms.projectorRange = shader.getUniform("projectorRange");
+    }
+    shader.setUniform1i(m_uniforms.gridMode, gridMode);
+    if (m_gridMode == GridMode::Projected) {
+        // The grid follows the viewport, so it never needs rebuilding.
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        m_projectedX = std::max(2, viewport[2] / m_projectedCell + 1);
+        m_projectedZ = std::max(2, viewport[3] / m_projectedCell + 1);
+        shader.setUniform2i(m_uniforms.gridSize, m_projectedX, m_projectedZ);
+        return;
+    }
+    shader.setUniform2i(m_uniforms.gridSize, xSegments, zSegments);
+    if (m_gridMode == GridMode::Instanced)
+        shader.setUniform2i(m_uniforms.instancePatch, m_tileSize, instancePatchesX());
+    if (m_gridMode == GridMode::Tessellation) {
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        shader.setUniform2f(m_uniforms.viewportSize, (float)viewport[2], (float)viewport[3]);
+        shader.setUniform1f(m_uniforms.tessPixels, m_tessPixels);
+        shader.setUniform1f(m_uniforms.tessError, m_tessError);
+    }
+}
+
+// A crest at the edge of the screen lies closer to the camera than the
+// trough the same ray meets. The grid is widened until the troughs
+// below the crests seen through the corners and middles of the screen's
+// edges are inside it.
+glm::vec4 Terrain::projectedRange(const glm::mat4& modelViewProjection, const glm::mat4& projectorInverse,
+                                  float nearHeight, float farHeight){
+    glm::vec4 range(-1.0f, -1.0f, 1.0f, 1.0f);
+    for (int i = 0; i < 9; i++) {
+        if (i == 4)
+            continue;   // The center of the screen
+        glm::vec2 ndc((float)(i % 3) - 1.0f, (float)(i / 3) - 1.0f);
+        glm::vec4 nearPoint = projectorInverse * glm::vec4(ndc, -1.0f, 1.0f);
+        glm::vec4 farPoint = projectorInverse * glm::vec4(ndc, 1.0f, 1.0f);
+        nearPoint /= nearPoint.w;
+        farPoint /= farPoint.w;
+        float a = nearPoint.y - nearHeight;
+        float b = farPoint.y - nearHeight;
+        if (a * b >= 0.0f)
+            continue;   // The ray never meets the crests.
+        glm::vec4 crest = glm::mix(nearPoint, farPoint, a / (a - b));
+        glm::vec4 clip = modelViewProjection * glm::vec4(crest.x, farHeight, crest.z, 1.0f);
+        if (clip.w <= 0.0f)
+            continue;
+        glm::vec2 trough = glm::vec2(clip) / clip.w;
+        range.x = std::min(range.x, trough.x);
+        range.y = std::min(range.y, trough.y);
+        range.z = std::max(range.z, trough.x);
+        range.w = std::max(range.w, trough.y);
+    }
+    // Crests right below a camera that is close to the waves could ask
+    // for much more than the screen. The grid would be spread too thin.
+    const float MAX_RANGE = 4.0f;
+    return glm::clamp(range, -MAX_RANGE, MAX_RANGE);
+}
+
+void Terrain::cull(const glm::mat4& modelViewProjection, const glm::vec3& eye, float maxHeight){
+    if (m_gridMode == GridMode::Projected) {
+        // Called with the shader still bound by setUniforms().
+        if (m_shader == nullptr)
+            return;
+        glm::mat4 projectorInverse = glm::inverse(modelViewProjection);
+        // The grid is projected onto the troughs furthest from the
+        // camera, which reach the most of the plane.
+        float farHeight = (eye.y >= 0.0f) ? -maxHeight : maxHeight;
+        glm::vec4 range = projectedRange(modelViewProjection, projectorInverse, -farHeight, farHeight);
+        m_shader->setUniformMatrix4fv(m_uniforms.projectorInverse, &projectorInverse[0][0]);
+        m_shader->setUniform1f(m_uniforms.projectorHeight, farHeight);
+        m_shader->setUniform4f(m_uniforms.projectorRange, range.x, range.y, range.z, range.w);
+        return;
+    }
+    if (m_gridMode == GridMode::Lod) {
+        PROFILE_SCOPE("Terrain::SelectLod");
+        m_lodEye = eye;
+        m_lod.Select(eye, Frustum(modelViewProjection), maxHeight, m_lodPatches);
+        unsigned long long quads = (unsigned long long)m_lod.GetPatchQuads() * m_lod.GetPatchQuads();
+        m_lastCull.tilesDrawn = (int)m_lodPatches.size();
+        m_lastCull.trianglesDrawn = 0;
+        for (const LodPatch& patch : m_lodPatches)
+            m_lastCull.trianglesDrawn += (patch.quadrant < 0) ? 2 * quads : quads / 2;
+        m_culledFrames++;
+        m_trianglesDrawn += m_lastCull.trianglesDrawn;
+        return;
+    }
+    if (m_gridMode != GridMode::Tiles)
+        return;
+    PROFILE_SCOPE("Terrain::Cull");
+
+    m_tileBounds.SetExtentY(maxHeight);
+    Frustum frustum(modelViewProjection);
+    int drawn = frustum.CullBoxes(m_tileBounds, m_tileVisible);
+
+    m_lastCull.tilesDrawn = drawn;
+    m_lastCull.trianglesDrawn = 0;
+    for (size_t i = 0; i < m_tiles.size(); i++) {
+        if (m_tileVisible[i])
+            m_lastCull.trianglesDrawn += m_tiles[i].triangles;
+    }
+    m_culledFrames++;
+    m_tilesCulled += m_lastCull.tiles - m_lastCull.tilesDrawn;
+    m_trianglesCulled += m_lastCull.triangles - m_lastCull.trianglesDrawn;
+}
+
+void Terrain::printCullStats(std::ostream& out){
+    if (m_gridMode == GridMode::Tessellation) {
+        out << "[Tessellation] Last frame: " << m_tessIndexCount / 4 << " patches of " << m_tileSize
+            << "x" << m_tileSize << " quads, " << m_lastCull.trianglesDrawn << " triangles generated ("
+            << getPlaneTriangleCount() << " at full resolution)\n";
+        if (m_tessFrames > 0)
+            out << "[Tessellation] Average over " << m_tessFrames << " frames: "
+                << (double)m_trianglesGenerated / m_tessFrames << " triangles per frame\n";
+        return;
+    }
+    if (m_gridMode == GridMode::Lod) {
+        std::vector<int> perLevel(m_lod.GetLevels(), 0);
+        for (const LodPatch& patch : m_lodPatches)
+            perLevel[patch.level]++;
+        out << "[LOD] Last frame: " << m_lodPatches.size() << " patches of " << m_lod.GetPatchQuads()
+            << "x" << m_lod.GetPatchQuads() << " quads, " << m_lastCull.trianglesDrawn << " triangles ("
+            << getPlaneTriangleCount() << " at full resolution)\n"
+            << "[LOD] Patches per level, finest first:";
+        for (int count : perLevel)
+            out << " " << count;
+        out << "\n";
+        if (m_culledFrames > 0)
+            out << "[LOD] Average over " << m_culledFrames << " frames: "
+                << (double)m_trianglesDrawn / m_culledFrames << " triangles per frame\n";
+        return;
+    }
+    if (m_gridMode != GridMode::Tiles)
+        return;
+    const CullStats& last = m_lastCull;
+    double culledPercent = (last.triangles > 0)
+        ? 100.0 * (double)(last.triangles - last.trianglesDrawn) / (double)last.triangles : 0.0;
+    out << "[Culling] Last frame: " << last.tilesDrawn << "/" << last.tiles << " tiles drawn ("
+        << last.tiles - last.tilesDrawn << " culled), "
+        << last.trianglesDrawn << "/" << last.triangles << " triangles drawn ("
+        << last.triangles - last.trianglesDrawn << " culled, " << culledPercent << "%)\n";
+    if (m_culledFrames > 0) {
+        out << "[Culling] Average over " << m_culledFrames << " frames: "
+            << (double)m_tilesCulled / m_culledFrames << " tiles and "
+            << (double)m_trianglesCulled / m_culledFrames << " triangles culled per frame\n";
+    }
+}
+
+unsigned int Terrain::getIndexCount(){
+    if (m_gridMode == GridMode::Procedural)
+        return proceduralStripCount(xSegments, zSegments);
+    if (m_gridMode == GridMode::Projected)
+        return proceduralStripCount(m_projectedX, m_projectedZ);
+    if (m_gridMode == GridMode::Tiles) {
+        unsigned int count = 0;
+        for (const Tile& tile : m_tiles)
+            count += tile.indexCount;
+        return count;
+    }
+    if (m_gridMode == GridMode::Lod)
+        return m_lodIndexCount;
+    if (m_gridMode == GridMode::Tessellation)
+        return m_tessIndexCount;
+    if (m_gridMode == GridMode::Instanced)
+        return m_instanceIndexCount;
+    return Object::getIndexCount();
+}
+
+// The patches and tessellation levels vary from frame to frame, so the
+// last frame's triangles are counted.
+unsigned long long Terrain::getTriangleCount(){
+    if (m_gridMode == GridMode::Lod || m_gridMode == GridMode::Tessellation)
+        return m_lastCull.trianglesDrawn;
+    // The projected grid does not depend on the plane's dimensions.
+    if (m_gridMode == GridMode::Projected)
+        return (m_projectedX < 2 || m_projectedZ < 2) ? 0 : 2ULL * (m_projectedX - 1) * (m_projectedZ - 1);
+    return getPlaneTriangleCount();
+}
+
+// Two triangles per quad, however the strips are joined
+unsigned long long Terrain::getPlaneTriangleCount(){
+    if (xSegments < 2 || zSegments < 2)
+        return 0;
+    return 2ULL * (xSegments - 1) * (zSegments - 1);
+}
 
+bool Terrain::ParseGridMode(const std::string& name, GridMode& mode){
+    if (name == "vertexBuffer")
+        mode = GridMode::VertexBuffer;
+    else if (name == "procedural")
+        mode = GridMode::Procedural;
+    else if (name == "tiles")
+        mode = GridMode::Tiles;
+    else if (name == "lod")
+        mode = GridMode::Lod;
+    else if (name == "tessellation")
+        mode = GridMode::Tessellation;
+    else if (name == "projected")
+        mode = GridMode::Projected;
+    else if (name == "instanced")
+        mode = GridMode::Instanced;
+    else
+        return false;
+    return true;
 }
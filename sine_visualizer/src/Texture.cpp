@@ -9,7 +9,7 @@
 #include <glad/glad.h>
 
 // Default Constructor
-Texture::Texture() {
+Texture::Texture() : m_TextureID(0) {
 
 }
 
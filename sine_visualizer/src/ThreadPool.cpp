@@ -0,0 +1,105 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool& ThreadPool::Get() {
+    static ThreadPool pool;
+    return pool;
+}
+
+ThreadPool::ThreadPool() : m_stop(false), m_generation(0), m_busyWorkers(0),
+                           m_task(nullptr), m_count(0), m_bandSize(0), m_bands(0), m_nextBand(0) {
+}
+
+ThreadPool::~ThreadPool() {
+    StopWorkers();
+}
+
+void ThreadPool::SetThreadCount(int threads) {
+    if (threads <= 0)
+        threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    if (threads == GetThreadCount())
+        return;
+
+    StopWorkers();
+    m_stop = false;
+    for (int i = 1; i < threads; i++)
+        m_workers.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+}
+
+void ThreadPool::StopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+}
+
+void ThreadPool::ParallelFor(int count, int grain, const std::function<void(int, int)>& task) {
+    if (count <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+    // A few bands per thread balances uneven bands, while keeping
+    // each band large enough to be worth handing out.
+    int threads = GetThreadCount();
+    int bandSize = std::max(grain, (count + threads * 4 - 1) / (threads * 4));
+    int bands = (count + bandSize - 1) / bandSize;
+    if (m_workers.empty() || bands == 1) {
+        task(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &task;
+        m_count = count;
+        m_bandSize = bandSize;
+        m_bands = bands;
+        m_nextBand = 0;
+        m_busyWorkers = (int)m_workers.size();
+        m_generation++;
+    }
+    m_wake.notify_all();
+
+    // The calling thread works too.
+    RunBands();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_busyWorkers == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [this, seen] { return m_stop || m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+        }
+
+        RunBands();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busyWorkers == 0)
+            m_done.notify_one();
+    }
+}
+
+void ThreadPool::RunBands() {
+    for (;;) {
+        int band = m_nextBand++;
+        if (band >= m_bands)
+            return;
+        int begin = band * m_bandSize;
+        int end = std::min(m_count, begin + m_bandSize);
+        (*m_task)(begin, end);
+    }
+}
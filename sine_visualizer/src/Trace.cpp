@@ -0,0 +1,98 @@
+#if defined(LINUX) || defined(MINGW)
+    #include <SDL2/SDL.h>
+#else // This works for Mac
+    #include <SDL.h>
+#endif
+
+#include "Trace.h"
+#include "Profiler.h"
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+Trace& Trace::Get() {
+    static Trace trace;
+    return trace;
+}
+
+Trace::Trace() : m_enabled(false), m_written(0), m_startTicks(0) {
+}
+
+void Trace::Start(size_t capacity) {
+    if (capacity == 0)
+        capacity = DEFAULT_CAPACITY;
+    // Allocate everything up front so recording never allocates.
+    m_events.assign(capacity, Event());
+    m_written = 0;
+    m_startTicks = SDL_GetPerformanceCounter();
+    m_enabled = true;
+}
+
+void Trace::Stop() {
+    m_enabled = false;
+}
+
+unsigned int Trace::ThreadID() {
+    static std::atomic<unsigned int> nextID(0);
+    thread_local unsigned int id = nextID++;
+    return id;
+}
+
+void Trace::Record(int section, unsigned long long startTicks, unsigned long long endTicks) {
+    if (!m_enabled || m_events.empty())
+        return;
+    // The slot is claimed atomically so other threads can record too.
+    unsigned long long index = m_written++;
+    Event& event = m_events[index % m_events.size()];
+    event.start = startTicks;
+    event.end = endTicks;
+    event.section = section;
+    event.thread = ThreadID();
+}
+
+void Trace::RecordFrame(unsigned long long startTicks, unsigned long long endTicks) {
+    Record(-1, startTicks, endTicks);
+}
+
+size_t Trace::GetEventCount() const {
+    unsigned long long written = m_written;
+    return (written < m_events.size()) ? (size_t)written : m_events.size();
+}
+
+bool Trace::WriteJSON(const std::string& filepath) const {
+    std::ofstream file(filepath.c_str());
+    if (!file.is_open()) {
+        std::cout << "ERROR - Unable to write trace file: " << filepath << "\n";
+        return false;
+    }
+
+    std::vector<std::string> names = Profiler::Get().GetSectionNames();
+    // Timestamps are in microseconds.
+    double toMicroseconds = 1.0e6 / (double)SDL_GetPerformanceFrequency();
+
+    size_t count = GetEventCount();
+    unsigned long long written = m_written;
+    // The oldest event sits right after the newest once the ring wrapped.
+    size_t first = (written > m_events.size()) ? (size_t)(written % m_events.size()) : 0;
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"3dSineVisualizer\"}}";
+    for (size_t i = 0; i < count; i++) {
+        const Event& event = m_events[(first + i) % m_events.size()];
+        std::string name = "Frame";
+        if (event.section >= 0 && event.section < (int)names.size())
+            name = names[event.section];
+        // Events from before Start() would have negative timestamps.
+        if (event.start < m_startTicks)
+            continue;
+        file << ",\n{\"name\":\"" << name << "\",\"cat\":\"" << (event.section < 0 ? "frame" : "section") << "\""
+             << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+             << ",\"ts\":" << (double)(event.start - m_startTicks) * toMicroseconds
+             << ",\"dur\":" << (double)(event.end - event.start) * toMicroseconds << "}";
+    }
+    file << "\n]}\n";
+    std::cout << "Saved " << count << " trace events to " << filepath << "\n";
+    return true;
+}
@@ -3,7 +3,7 @@
 
 Transform::Transform(){
 	std::cout << "(Transform.cpp) Constructor Called\n";
-    modelTransformMatrix = glm::mat4();
+    modelTransformMatrix = glm::mat4(1.0f);
 }
 
 Transform::~Transform(){
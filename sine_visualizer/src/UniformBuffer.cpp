@@ -0,0 +1,147 @@
+#include "UniformBuffer.h"
+
+#include <cstring>
+#include <iostream>
+
+// Rounds a size up to a multiple of alignment
+static GLsizeiptr alignUp(GLsizeiptr size, GLsizeiptr alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+UniformBuffer& UniformBuffer::Get() {
+    static UniformBuffer uniformBuffer;
+    return uniformBuffer;
+}
+
+UniformBuffer::UniformBuffer() : m_ring(0), m_lights(0), m_objectOffset(0), m_slotSize(0), m_nextSlot(0), m_fences(), m_writtenSegments(0), m_warnedFull(false), m_lastLights(), m_lightsUploaded(false) {
+}
+
+UniformBuffer::~UniformBuffer() {
+    // Buffers are released in Shutdown(), while the context still
+    // exists.
+}
+
+void UniformBuffer::Shutdown() {
+    if (m_ring != 0)
+        glDeleteBuffers(1, &m_ring);
+    if (m_lights != 0)
+        glDeleteBuffers(1, &m_lights);
+    for (GLsync& fence : m_fences) {
+        if (fence != 0)
+            glDeleteSync(fence);
+        fence = 0;
+    }
+    m_ring = 0;
+    m_lights = 0;
+    m_nextSlot = 0;
+    m_writtenSegments = 0;
+    m_lightsUploaded = false;
+}
+
+void UniformBuffer::BindBlocks(GLuint program) {
+    const char* names[] = {"FrameBlock", "ObjectBlock", "LightsBlock"};
+    const GLuint bindings[] = {FRAME_BLOCK_BINDING, OBJECT_BLOCK_BINDING, LIGHTS_BLOCK_BINDING};
+    for (int i = 0; i < 3; i++) {
+        // Programs that do not use a block skip it.
+        GLuint index = glGetUniformBlockIndex(program, names[i]);
+        if (index != GL_INVALID_INDEX)
+            glUniformBlockBinding(program, index, bindings[i]);
+    }
+}
+
+void UniformBuffer::create() {
+    // Every slot and block within it has to start at a multiple of
+    // the alignment glBindBufferRange() asks for.
+    GLint alignment = 256;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    m_objectOffset = alignUp(sizeof(FrameBlock), alignment);
+    m_slotSize = alignUp(m_objectOffset + sizeof(ObjectBlock), alignment);
+
+    glGenBuffers(1, &m_ring);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ring);
+    glBufferData(GL_UNIFORM_BUFFER, m_slotSize * RING_SLOTS, nullptr, GL_DYNAMIC_DRAW);
+
+    glGenBuffers(1, &m_lights);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lights);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(LightsBlock), nullptr, GL_STATIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, LIGHTS_BLOCK_BINDING, m_lights);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+int UniformBuffer::Write(const FrameBlock& frame, const ObjectBlock& object) {
+    if (m_ring == 0)
+        create();
+    int slot = m_nextSlot;
+    m_nextSlot = (m_nextSlot + 1) % RING_SLOTS;
+    int segment = slot / SEGMENT_SLOTS;
+    if (slot % SEGMENT_SLOTS == 0) {
+        // Nodes are all updated before any is drawn, so a segment
+        // written twice in a frame loses the first object's blocks.
+        if ((m_writtenSegments & (1u << segment)) != 0 && !m_warnedFull) {
+            std::cout << "(UniformBuffer.cpp) ERROR, more objects in a frame than the uniform ring holds\n";
+            m_warnedFull = true;
+        }
+        waitForSegment(segment);
+    }
+    m_writtenSegments |= 1u << segment;
+
+    // The GPU is done with this slot, so there is nothing to wait for,
+    // and the driver can discard what the slot held.
+    glBindBuffer(GL_UNIFORM_BUFFER, m_ring);
+    void* data = glMapBufferRange(GL_UNIFORM_BUFFER, slot * m_slotSize, m_slotSize,
+                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (data != nullptr) {
+        std::memcpy(data, &frame, sizeof(FrameBlock));
+        std::memcpy((char*)data + m_objectOffset, &object, sizeof(ObjectBlock));
+        glUnmapBuffer(GL_UNIFORM_BUFFER);
+    } else {
+        std::cout << "(UniformBuffer.cpp) ERROR, unable to map the uniform ring\n";
+    }
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    return slot;
+}
+
+void UniformBuffer::Bind(int slot) {
+    if (m_ring == 0)
+        return;
+    GLintptr offset = slot * m_slotSize;
+    glBindBufferRange(GL_UNIFORM_BUFFER, FRAME_BLOCK_BINDING, m_ring, offset, sizeof(FrameBlock));
+    glBindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, m_ring, offset + m_objectOffset, sizeof(ObjectBlock));
+}
+
+void UniformBuffer::EndFrame() {
+    for (int segment = 0; segment < RING_SLOTS / SEGMENT_SLOTS; segment++) {
+        if ((m_writtenSegments & (1u << segment)) == 0)
+            continue;
+        // The new fence passes after the old one, so the old one is
+        // no longer needed.
+        if (m_fences[segment] != 0)
+            glDeleteSync(m_fences[segment]);
+        m_fences[segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    m_writtenSegments = 0;
+}
+
+void UniformBuffer::waitForSegment(int segment) {
+    GLsync fence = m_fences[segment];
+    if (fence == 0)
+        return;
+    // Flushes the fence to the GPU the first time, so it can pass.
+    const GLuint64 ONE_SECOND = 1000000000;
+    while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, ONE_SECOND) == GL_TIMEOUT_EXPIRED) {
+    }
+    glDeleteSync(fence);
+    m_fences[segment] = 0;
+}
+
+void UniformBuffer::SetLights(const LightsBlock& lights) {
+    if (m_lights == 0)
+        create();
+    if (m_lightsUploaded && std::memcmp(&lights, &m_lastLights, sizeof(LightsBlock)) == 0)
+        return;
+    glBindBuffer(GL_UNIFORM_BUFFER, m_lights);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightsBlock), &lights);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_lastLights = lights;
+    m_lightsUploaded = true;
+}
@@ -0,0 +1,194 @@
+#include "VertexCache.h"
+#include "Geometry.h"
+#include "Terrain.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+// Tuning constants from Forsyth's article
+static const float CACHE_DECAY_POWER = 1.5f;
+static const float LAST_TRIANGLE_SCORE = 0.75f;
+static const float VALENCE_BOOST_SCALE = 2.0f;
+static const float VALENCE_BOOST_POWER = 0.5f;
+
+// Score of a vertex at a position in the cache (-1 when it is not in
+// it) with a number of triangles still to be added.
+static float vertexScore(int cachePosition, int cacheSize, int remaining) {
+    if (remaining == 0)
+        return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        // The vertices of the last triangle get a fixed score, so the
+        // next triangle does not just reuse the same edge.
+        if (cachePosition < 3) {
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scale = 1.0f / (cacheSize - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+    // Vertices with few triangles left are finished first, so they do
+    // not have to be transformed again later.
+    score += VALENCE_BOOST_SCALE * std::pow((float)remaining, -VALENCE_BOOST_POWER);
+    return score;
+}
+
+void VertexCache::Optimize(std::vector<unsigned int>& triangles, int cacheSize) {
+    size_t triangleCount = triangles.size() / 3;
+    if (triangleCount == 0)
+        return;
+    cacheSize = std::max(cacheSize, 4);
+    unsigned int vertexCount = *std::max_element(triangles.begin(), triangles.end()) + 1;
+
+    // Triangles of every vertex, stored one vertex after another
+    std::vector<unsigned int> adjacencyStart(vertexCount + 1, 0);
+    for (unsigned int index : triangles)
+        adjacencyStart[index + 1]++;
+    for (unsigned int v = 0; v < vertexCount; v++)
+        adjacencyStart[v + 1] += adjacencyStart[v];
+    std::vector<unsigned int> adjacency(triangles.size());
+    std::vector<unsigned int> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+    for (size_t t = 0; t < triangleCount; t++) {
+        for (int k = 0; k < 3; k++)
+            adjacency[fill[triangles[t * 3 + k]]++] = (unsigned int)t;
+    }
+    // Triangles not added yet come first in each vertex's list.
+    std::vector<int> remaining(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        remaining[v] = adjacencyStart[v + 1] - adjacencyStart[v];
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        score[v] = vertexScore(-1, cacheSize, remaining[v]);
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        triangleScore[t] = score[triangles[t * 3]] + score[triangles[t * 3 + 1]] + score[triangles[t * 3 + 2]];
+    std::vector<bool> added(triangleCount, false);
+
+    // Three extra entries hold the vertices pushed out by a triangle.
+    std::vector<int> cache;
+    std::vector<int> nextCache;
+    cache.reserve(cacheSize + 3);
+    nextCache.reserve(cacheSize + 3);
+
+    std::vector<unsigned int> ordered;
+    ordered.reserve(triangles.size());
+    size_t cursor = 0;
+    long long best = -1;
+    while (ordered.size() < triangles.size()) {
+        // Nothing in the cache has triangles left, so start over from
+        // the next triangle in the original order.
+        if (best < 0) {
+            while (added[cursor])
+                cursor++;
+            best = (long long)cursor;
+        }
+
+        const unsigned int* triangle = &triangles[best * 3];
+        ordered.insert(ordered.end(), triangle, triangle + 3);
+        added[best] = true;
+
+        // The new triangle's vertices move to the front of the cache.
+        nextCache.assign(triangle, triangle + 3);
+        for (int v : cache) {
+            if (v != (int)triangle[0] && v != (int)triangle[1] && v != (int)triangle[2])
+                nextCache.push_back(v);
+        }
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = triangle[k];
+            unsigned int* first = &adjacency[adjacencyStart[v]];
+            unsigned int* last = first + remaining[v];
+            *std::find(first, last, (unsigned int)best) = *(last - 1);
+            remaining[v]--;
+        }
+
+        // Rescore every vertex that moved, and the triangles using them.
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            int v = nextCache[i];
+            cachePosition[v] = (i < (size_t)cacheSize) ? (int)i : -1;
+            score[v] = vertexScore(cachePosition[v], cacheSize, remaining[v]);
+        }
+        best = -1;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            int v = nextCache[i];
+            for (int a = 0; a < remaining[v]; a++) {
+                unsigned int t = adjacency[adjacencyStart[v] + a];
+                triangleScore[t] = score[triangles[t * 3]] + score[triangles[t * 3 + 1]] + score[triangles[t * 3 + 2]];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    best = t;
+                }
+            }
+        }
+        if (nextCache.size() > (size_t)cacheSize)
+            nextCache.resize(cacheSize);
+        cache.swap(nextCache);
+    }
+    triangles.swap(ordered);
+}
+
+// A vertex is in the FIFO if fewer than cacheSize misses happened
+// since it was added, so no queue needs to be kept.
+VertexCacheStats VertexCache::Simulate(const std::vector<unsigned int>& triangles, int cacheSize) {
+    VertexCacheStats stats;
+    stats.triangles = triangles.size() / 3;
+    if (triangles.empty())
+        return stats;
+    unsigned int vertexCount = *std::max_element(triangles.begin(), triangles.end()) + 1;
+    std::vector<long long> addedAt(vertexCount, -1);
+    long long misses = 0;
+    for (unsigned int v : triangles) {
+        if (addedAt[v] < 0) {
+            stats.vertices++;
+        } else if (misses - addedAt[v] < cacheSize) {
+            continue;
+        }
+        addedAt[v] = misses++;
+    }
+    stats.transforms = misses;
+    stats.acmr = (double)stats.transforms / (double)stats.triangles;
+    stats.atvr = (double)stats.transforms / (double)stats.vertices;
+    return stats;
+}
+
+bool VertexCache::Report(const std::vector<int>& sizes, std::ostream& out) {
+    const int cacheSizes[] = {16, 32};
+    out << "[VertexCache] FIFO cache simulation, ACMR (transforms per triangle) / ATVR (transforms per vertex)\n"
+        << "    " << std::left << std::setw(12) << "Size" << std::setw(12) << "Order";
+    for (int cacheSize : cacheSizes)
+        out << std::right << std::setw(18) << ("cache " + std::to_string(cacheSize));
+    out << std::right << std::setw(16) << "Optimize ms" << "\n";
+
+    for (int size : sizes) {
+        Geometry geometry;
+        Terrain::buildFlatPlane(geometry, size, size);
+        std::vector<unsigned int> strips = geometry.getTriangleList();
+        std::vector<unsigned int> optimized = strips;
+        auto start = std::chrono::steady_clock::now();
+        Optimize(optimized);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::string name = std::to_string(size) + "x" + std::to_string(size);
+        const std::vector<unsigned int>* orders[] = {&strips, &optimized};
+        const char* orderNames[] = {"strips", "forsyth"};
+        for (int o = 0; o < 2; o++) {
+            out << "    " << std::left << std::setw(12) << name << std::setw(12) << orderNames[o] << std::right;
+            for (int cacheSize : cacheSizes) {
+                VertexCacheStats stats = Simulate(*orders[o], cacheSize);
+                std::ostringstream cell;
+                cell << std::fixed << std::setprecision(3) << stats.acmr << " / " << stats.atvr;
+                out << std::setw(18) << cell.str();
+            }
+            if (o == 1)
+                out << std::fixed << std::setprecision(1) << std::setw(16) << milliseconds << std::defaultfloat;
+            out << "\n";
+        }
+    }
+    return true;
+}
@@ -3,6 +3,10 @@
 // Please do not redistribute without asking permission.
 
 // Functionality that we created
+#include "BuildBenchmark.h"
+#include "VertexCache.h"
+#include "Clock.h"
+#include "Options.h"
 #include "SDLGraphicsProgram.h"
 #include <iostream>
 
@@ -10,25 +14,46 @@ int main(int argc, char** argv){
 
 	std::cout << "(main.cpp) Beginning Intitialization\n";
 
-	int w, h;
-	std::cout << "Please select your window dimensions\n\tWidth: ";
-	std::cin >> w;
-	std::cout << "\tHeight: ";
-	std::cin >> h;
+	// Every setting can be passed in on the command line.
+	// Run with --help to see the full list.
+	ProgramOptions options;
+	if (!parseOptions(argc, argv, options)) {
+		return 1;
+	}
 
-	// Create an instance of an object for a SDLGraphicsProgram
-	// and run loop forever
-	if (argc == 1) {
-		// Use first to create a terrain map
-		SDLGraphicsProgram mySDLGraphicsProgram(w, h);
-		mySDLGraphicsProgram.loop();
+	// The clock soak, the build benchmark, and the cache report need
+	// no window or OpenGL context.
+	if (options.clockSoakDays > 0.0) {
+		return SimulationClock::Soak(options.clockSoakDays, options.simulationRate, std::cout) ? 0 : 1;
 	}
-	else if (argc == 2) {
-		// Textures have not yet been tested
-		SDLGraphicsProgram mySDLGraphicsProgram(w, h, argv[1]);
-		mySDLGraphicsProgram.loop();
+	if (!options.buildBenchSizes.empty()) {
+		return BuildBenchmark::Run(options.buildBenchSizes, options.buildThreads, std::cout) ? 0 : 1;
+	}
+	if (!options.cacheReportSizes.empty()) {
+		return VertexCache::Report(options.cacheReportSizes, std::cout) ? 0 : 1;
+	}
+
+	// Only ask for the window dimensions when they were not passed in.
+	if (options.windowWidth <= 0 || options.windowHeight <= 0) {
+		std::cout << "Please select your window dimensions\n\tWidth: ";
+		std::cin >> options.windowWidth;
+		std::cout << "\tHeight: ";
+		std::cin >> options.windowHeight;
+	}
+
+	// Create an instance of an object for a SDLGraphicsProgram
+	// and run loop forever, or render offscreen and exit when
+	// running headless or benchmarking.
+	SDLGraphicsProgram mySDLGraphicsProgram(options);
+	if (options.benchmark) {
+		if (!mySDLGraphicsProgram.runBenchmark()) {
+			return 1;
+		}
+	} else if (options.headless) {
+		if (!mySDLGraphicsProgram.runHeadless()) {
+			return 1;
+		}
 	} else {
-		SDLGraphicsProgram mySDLGraphicsProgram(w, h, argv[1], argv[2]);
 		mySDLGraphicsProgram.loop();
 	}
 	